@@ -0,0 +1,453 @@
+// Copyright 2025 Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+// Writes and reads back synthetic animations to measure exporter and reader
+// throughput: write and read MB/s, open and seek latency, and peak RSS. Run
+// with --help for the options; --sweep covers array sizes from 1 KiB to 1 GiB.
+
+// agx
+#define AGX_READ_IMPL 1
+#include "agx/agx_read.h"
+#define AGX_WRITE_IMPL 1
+#include "agx/agx_write.h"
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+// peak RSS, page cache eviction
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+struct BenchOptions
+{
+  const char *file{"agx_bench.agxb"};
+  uint32_t steps{32};
+  uint32_t params{4}; // arrays per time step
+  uint64_t arrayBytes{uint64_t(1) << 20};
+  bool sweep{false};
+  uint64_t sweepBytes{uint64_t(1) << 28}; // data per --sweep run
+  bool stream{false};
+  uint32_t threads{1};
+  AGXCodec codec{AGX_CODEC_NONE};
+  int level{0};
+  uint32_t keyframes{0}; // delta encoding keyframe interval, 0 = off
+  uint64_t chunkBytes{0};
+  uint32_t alignment{0};
+  AGXIOBackend writeIO{AGX_IO_STDIO};
+  std::string readMode{"stdio"}; // stdio, mapped, direct
+  bool cold{false};
+  uint32_t seeks{200};
+  bool keep{false};
+};
+
+struct BenchResult
+{
+  uint64_t dataBytes{0}; // payload bytes set / read
+  uint64_t fileBytes{0};
+  double writeSeconds{0};
+  double readSeconds{0};
+  double openSeconds{0}; // median
+  double seekSeconds{0}; // mean
+};
+
+using Clock = std::chrono::steady_clock;
+
+// Most time steps of a --sweep run
+static const uint64_t AGX_BENCH_MAX_SWEEP_STEPS = 16384;
+
+// Keeps the payload reads of runRead() from being optimized away
+static volatile uint8_t g_sink = 0;
+
+static double secondsSince(Clock::time_point t0)
+{
+  return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static bool parseBytes(const char *s, uint64_t &out)
+{
+  char *end = nullptr;
+  const double v = std::strtod(s, &end);
+  if (end == s || v < 0)
+    return false;
+  uint64_t scale = 1;
+  switch (*end) {
+  case 'k':
+  case 'K':
+    scale = uint64_t(1) << 10;
+    ++end;
+    break;
+  case 'm':
+  case 'M':
+    scale = uint64_t(1) << 20;
+    ++end;
+    break;
+  case 'g':
+  case 'G':
+    scale = uint64_t(1) << 30;
+    ++end;
+    break;
+  default:
+    break;
+  }
+  if (*end != '\0')
+    return false;
+  out = static_cast<uint64_t>(v * double(scale));
+  return true;
+}
+
+static std::string formatBytes(uint64_t n)
+{
+  const char *units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+  double v = double(n);
+  int u = 0;
+  while (v >= 1024.0 && u < 4) {
+    v /= 1024.0;
+    ++u;
+  }
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.4g %s", v, units[u]);
+  return buf;
+}
+
+static double peakRssMiB()
+{
+#ifndef _WIN32
+  struct rusage ru;
+  if (::getrusage(RUSAGE_SELF, &ru) != 0)
+    return 0.0;
+#ifdef __APPLE__
+  return double(ru.ru_maxrss) / (1024.0 * 1024.0); // bytes
+#else
+  return double(ru.ru_maxrss) / 1024.0; // KiB
+#endif
+#else
+  return 0.0;
+#endif
+}
+
+// Drop the file's pages from the page cache, so reads hit the disk
+static void evictFile(const char *file)
+{
+#if !defined(_WIN32) && !defined(__APPLE__)
+  const int fd = ::open(file, O_RDONLY);
+  if (fd < 0)
+    return;
+  ::fdatasync(fd);
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  ::close(fd);
+#else
+  (void)file;
+#endif
+}
+
+// Vertex positions of array 'param' at time step 't': a wave travelling over
+// a fixed point set, so consecutive steps are similar (as in real animations)
+static void fillPositions(std::vector<float> &v, uint32_t t, uint32_t param)
+{
+  const float phase = 0.1f * float(t) + float(param);
+  for (size_t i = 0; i + 2 < v.size(); i += 3) {
+    const float x = float(i % 3072) * (1.f / 3072.f);
+    const float y = float(i / 3072) * (1.f / 1024.f);
+    v[i] = x;
+    v[i + 1] = y;
+    v[i + 2] = 0.1f * std::sin(8.f * x + phase) * std::cos(6.f * y + phase);
+  }
+}
+
+static AGXReader openReader(const BenchOptions &o)
+{
+  if (o.readMode == "mapped")
+    return agxNewReaderMapped(o.file);
+  if (o.readMode == "direct")
+    return agxNewReaderWithIO(o.file, AGX_IO_DIRECT);
+  return agxNewReader(o.file);
+}
+
+static bool runWrite(const BenchOptions &o, BenchResult &res)
+{
+  const uint64_t elements = std::max<uint64_t>(1, o.arrayBytes / 12);
+  std::vector<float> positions(3 * elements);
+
+  const Clock::time_point t0 = Clock::now();
+  AGXExporter ex = agxNewExporter();
+  agxSetObjectSubtype(ex, "triangle");
+  agxSetCompression(ex, o.codec, o.level);
+  agxSetDeltaEncoding(ex, o.keyframes > 0, o.keyframes);
+  agxSetArrayChunking(ex, o.chunkBytes);
+  agxSetPayloadAlignment(ex, o.alignment);
+  agxSetWriteThreadCount(ex, o.threads);
+  agxSetIOBackend(ex, o.writeIO);
+  if (o.stream && agxBeginStreaming(ex, o.file) != 0) {
+    agxReleaseExporter(ex);
+    return false;
+  }
+
+  const float bboxMin[3] = {0.f, 0.f, -0.1f};
+  const float bboxMax[3] = {1.f, 1.f, 0.1f};
+  agxSetParameter(ex, "bbox.min", ANARI_FLOAT32_VEC3, bboxMin);
+  agxSetParameter(ex, "bbox.max", ANARI_FLOAT32_VEC3, bboxMax);
+  agxSetTimeStepCount(ex, o.steps);
+  for (uint32_t t = 0; t < o.steps; ++t) {
+    agxBeginTimeStep(ex, t);
+    for (uint32_t p = 0; p < o.params; ++p) {
+      const std::string name = "vertex.attribute" + std::to_string(p);
+      fillPositions(positions, t, p);
+      agxSetTimeStepParameterArray1D(ex,
+          t,
+          name.c_str(),
+          ANARI_FLOAT32_VEC3,
+          positions.data(),
+          elements);
+      res.dataBytes += 12 * elements;
+    }
+    const float time = float(t);
+    agxSetTimeStepParameter(ex, t, "time", ANARI_FLOAT32, &time);
+    agxEndTimeStep(ex, t);
+  }
+
+  const int rc = o.stream ? agxEndStreaming(ex) : agxWrite(ex, o.file);
+  agxReleaseExporter(ex);
+  res.writeSeconds = secondsSince(t0);
+  if (rc != 0)
+    return false;
+
+  std::FILE *f = std::fopen(o.file, "rb");
+  if (!f)
+    return false;
+  std::fseek(f, 0, SEEK_END);
+  res.fileBytes = static_cast<uint64_t>(std::ftell(f));
+  std::fclose(f);
+  return true;
+}
+
+static bool runRead(const BenchOptions &o, BenchResult &res)
+{
+  const int opens = 15;
+  std::vector<double> openTimes;
+  for (int i = 0; i < opens; ++i) {
+    const Clock::time_point t0 = Clock::now();
+    AGXReader r = openReader(o);
+    if (!r)
+      return false;
+    AGXHeader hdr;
+    agxReaderGetHeader(r, &hdr);
+    openTimes.push_back(secondsSince(t0));
+    agxReleaseReader(r);
+  }
+  std::sort(openTimes.begin(), openTimes.end());
+  res.openSeconds = openTimes[opens / 2];
+
+  // Sequential read of everything, touching each page of the payloads
+  if (o.cold)
+    evictFile(o.file);
+  Clock::time_point t0 = Clock::now();
+  AGXReader r = openReader(o);
+  if (!r)
+    return false;
+  uint64_t bytes = 0;
+  uint8_t checksum = 0;
+  AGXParamView v;
+  while (agxReaderNextConstant(r, &v) == 1)
+    bytes += v.dataBytes;
+  uint32_t index = 0, paramCount = 0;
+  while (agxReaderBeginNextTimeStep(r, &index, &paramCount) == 1) {
+    while (agxReaderNextTimeStepParam(r, &v) == 1) {
+      bytes += v.dataBytes;
+      const uint8_t *p = static_cast<const uint8_t *>(v.data);
+      for (uint64_t i = 0; i < v.dataBytes; i += 4096) // every page
+        checksum ^= p[i];
+    }
+  }
+  res.readSeconds = secondsSince(t0);
+
+  // Random seeks, each followed by reading the time step's header
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<uint32_t> pick(0, o.steps - 1);
+  t0 = Clock::now();
+  for (uint32_t i = 0; i < o.seeks; ++i) {
+    if (agxReaderSeekTimeStep(r, pick(rng)) != 0
+        || agxReaderBeginNextTimeStep(r, &index, &paramCount) != 1) {
+      agxReleaseReader(r);
+      return false;
+    }
+  }
+  res.seekSeconds = o.seeks ? secondsSince(t0) / o.seeks : 0.0;
+  agxReleaseReader(r);
+
+  g_sink = checksum;
+  return bytes >= res.dataBytes;
+}
+
+static void printHeader()
+{
+  std::printf("%10s %6s %6s %11s %11s %11s %9s %9s %9s\n",
+      "array",
+      "steps",
+      "params",
+      "file",
+      "write MB/s",
+      "read MB/s",
+      "open ms",
+      "seek us",
+      "RSS MiB");
+}
+
+static bool runOnce(const BenchOptions &o)
+{
+  BenchResult res;
+  if (!runWrite(o, res)) {
+    std::fprintf(stderr, "Error: failed to write '%s'\n", o.file);
+    return false;
+  }
+  if (!runRead(o, res)) {
+    std::fprintf(stderr, "Error: failed to read '%s'\n", o.file);
+    return false;
+  }
+  if (!o.keep)
+    std::remove(o.file);
+
+  const double mb = double(res.dataBytes) / 1e6;
+  std::printf("%10s %6u %6u %11s %11.1f %11.1f %9.3f %9.1f %9.1f\n",
+      formatBytes(o.arrayBytes).c_str(),
+      o.steps,
+      o.params,
+      formatBytes(res.fileBytes).c_str(),
+      mb / res.writeSeconds,
+      mb / res.readSeconds,
+      res.openSeconds * 1e3,
+      res.seekSeconds * 1e6,
+      peakRssMiB());
+  std::fflush(stdout);
+  return true;
+}
+
+static void printUsage(const char *argv0)
+{
+  std::fprintf(stderr,
+      "Usage: %s [options]\n"
+      "  --file <path>          output file (default agx_bench.agxb)\n"
+      "  --steps <n>            time steps (default 32)\n"
+      "  --params <n>           arrays per time step (default 4)\n"
+      "  --array-bytes <size>   bytes per array, e.g. 1K, 4M, 1G (default 1M)\n"
+      "  --sweep                array sizes 1K..1G, steps scaled to about\n"
+      "                         --sweep-bytes of data each (default 256M;\n"
+      "                         1G arrays need --params 1)\n"
+      "  --sweep-bytes <size>\n"
+      "  --stream               write with agxBeginStreaming/agxEndStreaming\n"
+      "  --threads <n>          agxWrite threads (default 1, 0 = all)\n"
+      "  --codec none|lz4|zstd  (default none), --level <n>\n"
+      "  --delta <k>            delta encoding, keyframe every k steps\n"
+      "  --chunk <size>         array chunking\n"
+      "  --align <n>            payload alignment\n"
+      "  --write-io stdio|direct\n"
+      "  --read stdio|mapped|direct (default stdio)\n"
+      "  --cold                 evict the file from the page cache before\n"
+      "                         the sequential read\n"
+      "  --seeks <n>            random seeks timed (default 200)\n"
+      "  --keep                 keep the file\n",
+      argv0);
+}
+
+int main(int argc, char **argv)
+{
+  BenchOptions o;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    auto number = [&](uint32_t &out) {
+      if (!value)
+        return false;
+      out = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+      ++i;
+      return true;
+    };
+    auto bytes = [&](uint64_t &out) {
+      if (!value || !parseBytes(value, out))
+        return false;
+      ++i;
+      return true;
+    };
+    bool ok = true;
+    if (arg == "--file" && value) {
+      o.file = value;
+      ++i;
+    } else if (arg == "--steps")
+      ok = number(o.steps) && o.steps > 0;
+    else if (arg == "--params")
+      ok = number(o.params);
+    else if (arg == "--array-bytes")
+      ok = bytes(o.arrayBytes);
+    else if (arg == "--sweep")
+      o.sweep = true;
+    else if (arg == "--sweep-bytes")
+      ok = bytes(o.sweepBytes);
+    else if (arg == "--stream")
+      o.stream = true;
+    else if (arg == "--threads")
+      ok = number(o.threads);
+    else if (arg == "--codec" && value) {
+      const std::string c = argv[++i];
+      o.codec = c == "lz4" ? AGX_CODEC_LZ4
+          : c == "zstd"    ? AGX_CODEC_ZSTD
+                           : AGX_CODEC_NONE;
+      ok = c == "none" || o.codec != AGX_CODEC_NONE;
+    } else if (arg == "--level" && value)
+      o.level = std::atoi(argv[++i]);
+    else if (arg == "--delta")
+      ok = number(o.keyframes);
+    else if (arg == "--chunk")
+      ok = bytes(o.chunkBytes);
+    else if (arg == "--align")
+      ok = number(o.alignment);
+    else if (arg == "--write-io" && value) {
+      const std::string io = argv[++i];
+      o.writeIO = io == "direct" ? AGX_IO_DIRECT : AGX_IO_STDIO;
+      ok = io == "direct" || io == "stdio";
+    } else if (arg == "--read" && value) {
+      o.readMode = argv[++i];
+      ok = o.readMode == "stdio" || o.readMode == "mapped"
+          || o.readMode == "direct";
+    } else if (arg == "--cold")
+      o.cold = true;
+    else if (arg == "--seeks")
+      ok = number(o.seeks);
+    else if (arg == "--keep")
+      o.keep = true;
+    else
+      ok = false;
+    if (!ok) {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (!agxCodecSupported(o.codec)) {
+    std::fprintf(stderr, "Error: codec not supported by this build\n");
+    return 1;
+  }
+
+  printHeader();
+  if (!o.sweep)
+    return runOnce(o) ? 0 : 2;
+
+  for (uint64_t size = uint64_t(1) << 10; size <= uint64_t(1) << 30;
+       size <<= 4) {
+    BenchOptions s = o;
+    s.arrayBytes = size;
+    const uint64_t perStep = std::max<uint64_t>(1, o.params) * size;
+    s.steps = static_cast<uint32_t>(std::min(AGX_BENCH_MAX_SWEEP_STEPS,
+        std::max<uint64_t>(1, o.sweepBytes / perStep)));
+    if (!runOnce(s))
+      return 2;
+  }
+  return 0;
+}
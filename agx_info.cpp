@@ -2,32 +2,459 @@
 // SPDX-License-Identifier: Apache-2.0
 
 // Prints header information of an .agxb (AGX binary) file using the AGX reader
-// API.
+// API. With --scan, also reads every constant and time step and reports where
+// the bytes go: per-parameter totals, the largest arrays, per-step sizes and
+// the bytes repeating earlier arrays (candidates for agxSetDeduplication).
+// --json prints the same information as a JSON object.
 
 // agx
 #define AGX_READ_IMPL 1
 #include "agx/agx_read.h"
 // std
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 static const char *endianStr(uint8_t little)
 {
   return little ? "little-endian" : "big-endian";
 }
 
+// Number of arrays listed as the largest ones
+static const size_t AGX_INFO_TOP_ARRAYS = 10;
+
+// Most time steps listed one by one in the text report
+static const size_t AGX_INFO_MAX_STEP_LINES = 32;
+
+// Totals of the records sharing a name within the constants or time steps
+struct ParamTotals
+{
+  std::string name;
+  bool constant{false};
+  uint8_t isArray{0};
+  ANARIDataType type{ANARI_UNKNOWN}; // element type of arrays
+  uint64_t records{0};
+  uint64_t bytes{0};
+  uint64_t maxBytes{0};
+  uint64_t duplicateBytes{0}; // bytes of arrays equal to an earlier one
+};
+
+struct ArrayInfo
+{
+  std::string name;
+  int64_t timeStep{-1}; // -1 for constants
+  ANARIDataType elementType{ANARI_UNKNOWN};
+  uint64_t elementCount{0};
+  uint8_t dimensions{1};
+  uint64_t numItems[3]{0, 1, 1};
+  uint64_t bytes{0};
+};
+
+struct StepInfo
+{
+  uint32_t params{0};
+  uint64_t bytes{0};
+  uint64_t duplicateBytes{0};
+};
+
+struct ScanReport
+{
+  std::vector<ParamTotals> params;
+  std::vector<ArrayInfo> largest; // sorted by decreasing size
+  std::vector<StepInfo> steps;
+  uint64_t constantBytes{0};
+  uint64_t stepBytes{0};
+  uint64_t duplicateBytes{0};
+  uint64_t fileBytes{0};
+  double seconds{0};
+  AGXReaderStats stats{};
+};
+
+class Scanner
+{
+ public:
+  explicit Scanner(ScanReport &report) : m_report(report) {}
+
+  void add(const AGXParamView &v, int64_t timeStep)
+  {
+    const std::string name(v.name, v.nameLength);
+    const bool constant = timeStep < 0;
+    ParamTotals &p = totals(name, constant, v);
+    p.records++;
+    p.bytes += v.dataBytes;
+    p.maxBytes = std::max(p.maxBytes, v.dataBytes);
+    (constant ? m_report.constantBytes : m_report.stepBytes) += v.dataBytes;
+
+    if (!v.isArray)
+      return;
+
+    // Arrays are compared by content hash and size; a false positive would
+    // need a 64-bit hash collision between equal-sized arrays
+    const std::string_view bytes(
+        static_cast<const char *>(v.data), static_cast<size_t>(v.dataBytes));
+    const uint64_t h = std::hash<std::string_view>{}(bytes) ^ v.dataBytes;
+    if (v.dataBytes > 0 && !m_seen.emplace(h, v.dataBytes).second) {
+      p.duplicateBytes += v.dataBytes;
+      m_report.duplicateBytes += v.dataBytes;
+      if (!constant)
+        m_report.steps.back().duplicateBytes += v.dataBytes;
+    }
+
+    ArrayInfo a;
+    a.name = name;
+    a.timeStep = timeStep;
+    a.elementType = v.elementType;
+    a.elementCount = v.elementCount;
+    a.dimensions = v.dimensions;
+    for (int d = 0; d < 3; ++d)
+      a.numItems[d] = v.numItems[d];
+    a.bytes = v.dataBytes;
+    addLargest(a);
+  }
+
+ private:
+  ParamTotals &totals(
+      const std::string &name, bool constant, const AGXParamView &v)
+  {
+    auto &index = constant ? m_constantIndex : m_stepIndex;
+    auto it = index.find(name);
+    if (it != index.end())
+      return m_report.params[it->second];
+    index.emplace(name, m_report.params.size());
+    ParamTotals p;
+    p.name = name;
+    p.constant = constant;
+    p.isArray = v.isArray;
+    p.type = v.isArray ? v.elementType : v.type;
+    m_report.params.push_back(p);
+    return m_report.params.back();
+  }
+
+  void addLargest(const ArrayInfo &a)
+  {
+    auto &largest = m_report.largest;
+    if (largest.size() == AGX_INFO_TOP_ARRAYS
+        && a.bytes <= largest.back().bytes)
+      return;
+    auto at = std::upper_bound(largest.begin(),
+        largest.end(),
+        a,
+        [](const ArrayInfo &x, const ArrayInfo &y) {
+          return x.bytes > y.bytes;
+        });
+    largest.insert(at, a);
+    if (largest.size() > AGX_INFO_TOP_ARRAYS)
+      largest.pop_back();
+  }
+
+  ScanReport &m_report;
+  std::unordered_map<std::string, size_t> m_constantIndex;
+  std::unordered_map<std::string, size_t> m_stepIndex;
+  std::unordered_map<uint64_t, uint64_t> m_seen; // content hash -> size
+};
+
+static uint64_t fileBytes(const char *path)
+{
+  uint64_t bytes = 0;
+  if (FILE *f = std::fopen(path, "rb")) {
+    if (std::fseek(f, 0, SEEK_END) == 0) {
+      const long size = std::ftell(f);
+      bytes = size > 0 ? static_cast<uint64_t>(size) : 0;
+    }
+    std::fclose(f);
+  }
+  return bytes;
+}
+
+// Read every constant and time step of 'r'. Returns false on read errors.
+static bool scanFile(AGXReader r, const char *path, ScanReport &report)
+{
+  const auto t0 = std::chrono::steady_clock::now();
+  agxReaderResetStats(r);
+  Scanner scanner(report);
+  AGXParamView v{};
+
+  agxReaderResetConstants(r);
+  int rc = 0;
+  while ((rc = agxReaderNextConstant(r, &v)) == 1)
+    scanner.add(v, -1);
+  if (rc < 0)
+    return false;
+
+  agxReaderResetTimeSteps(r);
+  uint32_t index = 0;
+  uint32_t count = 0;
+  while ((rc = agxReaderBeginNextTimeStep(r, &index, &count)) == 1) {
+    report.steps.emplace_back();
+    while ((rc = agxReaderNextTimeStepParam(r, &v)) == 1) {
+      report.steps.back().params++;
+      report.steps.back().bytes += v.dataBytes;
+      scanner.add(v, index);
+    }
+    if (rc < 0)
+      return false;
+  }
+  if (rc < 0)
+    return false;
+
+  report.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+          .count();
+  agxReaderGetStats(r, &report.stats);
+
+  std::sort(report.params.begin(),
+      report.params.end(),
+      [](const ParamTotals &a, const ParamTotals &b) {
+        return a.bytes > b.bytes;
+      });
+
+  // Split files: the manifest and all of its parts
+  report.fileBytes = fileBytes(path);
+  const char *part = nullptr;
+  for (uint32_t i = 0; (part = agxReaderGetPartFilename(r, i)); ++i)
+    report.fileBytes += fileBytes(part);
+  return true;
+}
+
+static double mib(uint64_t bytes)
+{
+  return bytes / (1024.0 * 1024.0);
+}
+
+static double percent(uint64_t part, uint64_t whole)
+{
+  return whole ? 100.0 * part / whole : 0.0;
+}
+
+static void printScan(const ScanReport &s)
+{
+  const uint64_t total = s.constantBytes + s.stepBytes;
+  std::printf("\nScan\n");
+  std::printf("  file size             : %.3f MiB\n", mib(s.fileBytes));
+  std::printf("  payload bytes         : %.3f MiB (constants %.3f MiB, "
+              "time steps %.3f MiB)\n",
+      mib(total),
+      mib(s.constantBytes),
+      mib(s.stepBytes));
+  std::printf("  duplicated bytes      : %.3f MiB (%.1f%% of payloads)\n",
+      mib(s.duplicateBytes),
+      percent(s.duplicateBytes, total));
+  std::printf("  bytes read            : %.3f MiB\n", mib(s.stats.bytesRead));
+  std::printf(
+      "  scan time             : %.3f s (%.1f MiB/s, %.3f s decoding)\n",
+      s.seconds,
+      s.seconds > 0 ? mib(total) / s.seconds : 0.0,
+      s.stats.decodeSeconds);
+
+  std::printf("\nParameters (by total size)\n");
+  std::printf("  %-24s %-9s %-20s %8s %12s %12s %12s\n",
+      "name",
+      "section",
+      "type",
+      "records",
+      "total MiB",
+      "max MiB",
+      "dup MiB");
+  for (const ParamTotals &p : s.params) {
+    std::printf("  %-24s %-9s %-20s %8llu %12.3f %12.3f %12.3f\n",
+        p.name.c_str(),
+        p.constant ? "constant" : "step",
+        anari::toString(p.type),
+        (unsigned long long)p.records,
+        mib(p.bytes),
+        mib(p.maxBytes),
+        mib(p.duplicateBytes));
+  }
+
+  std::printf("\nLargest arrays\n");
+  for (const ArrayInfo &a : s.largest) {
+    char where[32];
+    if (a.timeStep < 0)
+      std::snprintf(where, sizeof(where), "constant");
+    else
+      std::snprintf(where, sizeof(where), "step %lld", (long long)a.timeStep);
+    char shape[64];
+    int n = std::snprintf(
+        shape, sizeof(shape), "%llu", (unsigned long long)a.numItems[0]);
+    for (int d = 1; d < a.dimensions && n > 0 && n < (int)sizeof(shape); ++d) {
+      n += std::snprintf(shape + n,
+          sizeof(shape) - n,
+          "x%llu",
+          (unsigned long long)a.numItems[d]);
+    }
+    std::printf("  %-24s %-12s %-20s %12s elements %12.3f MiB\n",
+        a.name.c_str(),
+        where,
+        anari::toString(a.elementType),
+        shape,
+        mib(a.bytes));
+  }
+
+  if (s.steps.empty())
+    return;
+
+  uint64_t minBytes = UINT64_MAX;
+  uint64_t maxBytes = 0;
+  for (const StepInfo &t : s.steps) {
+    minBytes = std::min(minBytes, t.bytes);
+    maxBytes = std::max(maxBytes, t.bytes);
+  }
+  std::printf("\nTime steps\n");
+  std::printf("  size min/mean/max     : %.3f / %.3f / %.3f MiB\n",
+      mib(minBytes),
+      mib(s.stepBytes) / s.steps.size(),
+      mib(maxBytes));
+  if (s.steps.size() > AGX_INFO_MAX_STEP_LINES) {
+    std::printf("  (%zu time steps; use --json for the full list)\n",
+        s.steps.size());
+    return;
+  }
+  std::printf("  %6s %8s %12s %12s\n", "step", "params", "MiB", "dup MiB");
+  for (size_t i = 0; i < s.steps.size(); ++i) {
+    const StepInfo &t = s.steps[i];
+    std::printf("  %6zu %8u %12.3f %12.3f\n",
+        i,
+        t.params,
+        mib(t.bytes),
+        mib(t.duplicateBytes));
+  }
+}
+
+static void printJsonString(const std::string &s)
+{
+  std::putchar('"');
+  for (const char c : s) {
+    const unsigned char u = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\')
+      std::printf("\\%c", c);
+    else if (u < 0x20)
+      std::printf("\\u%04x", u);
+    else
+      std::putchar(c);
+  }
+  std::putchar('"');
+}
+
+static void printJson(const AGXHeader &hdr,
+    const char *path,
+    const char *subtype,
+    const ScanReport *s)
+{
+  std::printf("{\n  \"file\": ");
+  printJsonString(path);
+  std::printf(",\n  \"version\": %u,\n", hdr.version);
+  std::printf("  \"fileLittleEndian\": %s,\n",
+      hdr.fileLittleEndian ? "true" : "false");
+  std::printf("  \"objectType\": ");
+  printJsonString(anari::toString(hdr.objectType));
+  std::printf(",\n  \"subtype\": ");
+  printJsonString(subtype);
+  std::printf(",\n  \"timeSteps\": %u,\n", hdr.timeSteps);
+  std::printf("  \"constantParamCount\": %u,\n", hdr.constantParamCount);
+  std::printf("  \"parts\": %u", hdr.partCount);
+  if (!s) {
+    std::printf("\n}\n");
+    return;
+  }
+
+  std::printf(",\n  \"scan\": {\n");
+  std::printf("    \"fileBytes\": %llu,\n", (unsigned long long)s->fileBytes);
+  std::printf("    \"constantBytes\": %llu,\n",
+      (unsigned long long)s->constantBytes);
+  std::printf(
+      "    \"timeStepBytes\": %llu,\n", (unsigned long long)s->stepBytes);
+  std::printf("    \"duplicateBytes\": %llu,\n",
+      (unsigned long long)s->duplicateBytes);
+  std::printf("    \"bytesRead\": %llu,\n",
+      (unsigned long long)s->stats.bytesRead);
+  std::printf("    \"seconds\": %.6f,\n", s->seconds);
+  std::printf("    \"decodeSeconds\": %.6f,\n", s->stats.decodeSeconds);
+
+  std::printf("    \"params\": [");
+  for (size_t i = 0; i < s->params.size(); ++i) {
+    const ParamTotals &p = s->params[i];
+    std::printf("%s\n      {\"name\": ", i ? "," : "");
+    printJsonString(p.name);
+    std::printf(", \"section\": \"%s\", \"isArray\": %s, \"type\": ",
+        p.constant ? "constant" : "timeStep",
+        p.isArray ? "true" : "false");
+    printJsonString(anari::toString(p.type));
+    std::printf(
+        ", \"records\": %llu, \"bytes\": %llu, \"maxBytes\": %llu, "
+        "\"duplicateBytes\": %llu}",
+        (unsigned long long)p.records,
+        (unsigned long long)p.bytes,
+        (unsigned long long)p.maxBytes,
+        (unsigned long long)p.duplicateBytes);
+  }
+  std::printf("\n    ],\n");
+
+  std::printf("    \"largestArrays\": [");
+  for (size_t i = 0; i < s->largest.size(); ++i) {
+    const ArrayInfo &a = s->largest[i];
+    std::printf("%s\n      {\"name\": ", i ? "," : "");
+    printJsonString(a.name);
+    std::printf(", \"timeStep\": %lld, \"elementType\": ",
+        (long long)a.timeStep);
+    printJsonString(anari::toString(a.elementType));
+    std::printf(", \"elementCount\": %llu, \"numItems\": [",
+        (unsigned long long)a.elementCount);
+    for (int d = 0; d < a.dimensions; ++d)
+      std::printf("%s%llu", d ? ", " : "", (unsigned long long)a.numItems[d]);
+    std::printf("], \"bytes\": %llu}", (unsigned long long)a.bytes);
+  }
+  std::printf("\n    ],\n");
+
+  std::printf("    \"timeSteps\": [");
+  for (size_t i = 0; i < s->steps.size(); ++i) {
+    const StepInfo &t = s->steps[i];
+    std::printf(
+        "%s\n      {\"params\": %u, \"bytes\": %llu, \"duplicateBytes\": "
+        "%llu}",
+        i ? "," : "",
+        t.params,
+        (unsigned long long)t.bytes,
+        (unsigned long long)t.duplicateBytes);
+  }
+  std::printf("\n    ]\n  }\n}\n");
+}
+
 int main(int argc, char **argv)
 {
-  if (argc != 2) {
-    std::fprintf(stderr, "Usage: %s <file.agxb>\n", argv[0]);
+  bool scan = false;
+  bool json = false;
+  bool badArgs = false;
+  const char *path = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--scan") == 0)
+      scan = true;
+    else if (std::strcmp(argv[i], "--json") == 0)
+      json = true;
+    else if (!path && argv[i][0] != '-')
+      path = argv[i];
+    else
+      badArgs = true;
+  }
+  if (!path || badArgs) {
+    std::fprintf(stderr, "Usage: %s [--scan] [--json] <file.agxb>\n", argv[0]);
+    std::fprintf(stderr,
+        "  --scan  read all parameters and report sizes and duplicates\n"
+        "  --json  print the report as JSON\n");
     return 1;
   }
 
-  const char *path = argv[1];
-  AGXReader r = agxNewReader(path);
+  // Mapped reads keep payloads out of scratch copies while scanning
+  AGXReader r = scan ? agxNewReaderMapped(path) : nullptr;
+  if (!r)
+    r = agxNewReader(path);
   if (!r) {
     std::fprintf(stderr, "Error: failed to open or parse '%s'\n", path);
     return 2;
@@ -42,6 +469,19 @@ int main(int argc, char **argv)
 
   const char *subtype = agxReaderGetSubtype(r);
 
+  ScanReport report;
+  if (scan && !scanFile(r, path, report)) {
+    std::fprintf(stderr, "Error: failed to read parameters of '%s'\n", path);
+    agxReleaseReader(r);
+    return 4;
+  }
+
+  if (json) {
+    printJson(hdr, path, subtype, scan ? &report : nullptr);
+    agxReleaseReader(r);
+    return 0;
+  }
+
   std::cout << "AGXB header information (via reader API)\n";
   std::cout << "  version               : " << hdr.version << "\n";
   std::cout << "  endian marker         : 0x" << std::hex << std::uppercase
@@ -58,6 +498,13 @@ int main(int argc, char **argv)
   std::cout << "  subtype               : '" << subtype << "'\n";
   std::cout << "  timeSteps             : " << hdr.timeSteps << "\n";
   std::cout << "  constantParamCount    : " << hdr.constantParamCount << "\n";
+  if (hdr.partCount > 0)
+    std::cout << "  parts (split file)    : " << hdr.partCount << "\n";
+
+  std::cout.flush();
+
+  if (scan)
+    printScan(report);
 
   agxReleaseReader(r);
 
@@ -6,6 +6,7 @@
 #include "agx/agx_read.h"
 // std
 #include <cstdio>
+#include <cstring>
 #include <vector>
 
 static void printParam(const char *prefix, const AGXParamView &p)
@@ -29,14 +30,16 @@ static void printParam(const char *prefix, const AGXParamView &p)
 
 int main(int argc, char **argv)
 {
-  if (argc != 2) {
-    std::fprintf(stderr, "Usage: %s <file.agxb>\n", argv[0]);
+  const bool mapped = argc == 3 && std::strcmp(argv[1], "--mapped") == 0;
+  if (argc != 2 && !mapped) {
+    std::fprintf(stderr, "Usage: %s [--mapped] <file.agxb>\n", argv[0]);
     return 1;
   }
 
-  AGXReader r = agxNewReader(argv[1]);
+  const char *path = argv[argc - 1];
+  AGXReader r = mapped ? agxNewReaderMapped(path) : agxNewReader(path);
   if (!r) {
-    std::fprintf(stderr, "Failed to open '%s'\n", argv[1]);
+    std::fprintf(stderr, "Failed to open '%s'\n", path);
     return 2;
   }
 
@@ -0,0 +1,273 @@
+// Copyright 2025 Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// agx_anari.h - Sets the parameters read from AGXB files on ANARI objects.
+//
+// A binding ties one ANARI object (typically a geometry) to the parameters of
+// a reader: agxAnariSetConstants() / agxAnariSetTimeStep() read the records of
+// a section and set each one on the object, then commit it. Arrays are kept in
+// a pool per parameter name: while the element type and dimensions of a
+// parameter stay the same, its ANARIArray1D/2D/3D is mapped and the payload is
+// read (or, if compressed, decoded) straight into the mapped memory, so
+// playing back time steps creates no new device arrays.
+//
+// Usage: #define AGX_ANARI_IMPL in one translation unit (along with
+// AGX_READ_IMPL, in the same or another one) before including this header.
+
+#include <anari/anari.h>
+
+#include "agx_read.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Opaque binding handle
+typedef struct AGXAnariBinding_t *AGXAnariBinding;
+
+// Create a binding setting parameters on 'object' of 'device'. Both must
+// outlive the binding. Returns NULL on error.
+AGXAnariBinding agxNewAnariBinding(ANARIDevice device, ANARIObject object);
+
+// Release the pooled arrays (the object keeps its own references to the ones
+// still set on it) and the binding.
+void agxReleaseAnariBinding(AGXAnariBinding binding);
+
+// Set all constants of 'r' on the object and commit it. Returns 0 on success;
+// 1 on bad arguments, 2 on read errors, 3 if the device failed to map an
+// array. Parameters set before an error keep their new values.
+int agxAnariSetConstants(AGXAnariBinding binding, AGXReader r);
+
+// Seek 'r' to time step 'timeStep', set all of its parameters on the object
+// and commit it; the iteration position of 'r' is left after the step. Arrays
+// are mapped with anariMapArray(), which devices may block on while a frame
+// using them is rendering. Parameters of earlier steps missing from this one
+// keep their values. Payloads are set in file byte order; enable
+// agxReaderSetConvertByteOrder() for files needing a swap. Object handles and
+// arrays of them are skipped. Return values as for agxAnariSetConstants().
+int agxAnariSetTimeStep(
+    AGXAnariBinding binding, AGXReader r, uint32_t timeStep);
+
+// Counters of one binding, accumulated since it was created
+typedef struct AGXAnariStats
+{
+  uint64_t arraysCreated; // anariNewArray1D/2D/3D() calls
+  uint64_t arraysReused; // pooled arrays mapped and overwritten in place
+  uint64_t bytesUploaded; // array payloads read into mapped memory
+} AGXAnariStats;
+
+// Returns 0 on success; nonzero on error. 'out' is filled on success.
+int agxAnariGetStats(AGXAnariBinding binding, AGXAnariStats *out);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef AGX_ANARI_IMPL
+// std
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+struct AGXPooledArray
+{
+  ANARIArray array{nullptr};
+  ANARIDataType elementType{ANARI_UNKNOWN};
+  uint8_t dimensions{0};
+  uint64_t numItems[3]{};
+};
+
+struct AGXAnariBinding_t
+{
+  ANARIDevice device{nullptr};
+  ANARIObject object{nullptr};
+  std::unordered_map<std::string, AGXPooledArray> arrays;
+  std::string name; // null-terminated name of the current record
+  std::string value; // null-terminated string values
+  AGXAnariStats stats{};
+};
+
+// agxReaderPeek* / agxReaderNext* of one section
+using AGXRecordFn = int (*)(AGXReader, AGXParamView *);
+
+// Element types which can be copied into a device array as they are
+static bool isPlainDataType(ANARIDataType type)
+{
+  return type != ANARI_STRING && !anari::isObject(type)
+      && anari::sizeOf(type) > 0;
+}
+
+// Create a device array of the element type and dimensions of 'v'
+static ANARIArray newArray(ANARIDevice device, const AGXParamView &v)
+{
+  switch (v.dimensions) {
+  case 2:
+    return anariNewArray2D(device,
+        nullptr,
+        nullptr,
+        nullptr,
+        v.elementType,
+        v.numItems[0],
+        v.numItems[1]);
+  case 3:
+    return anariNewArray3D(device,
+        nullptr,
+        nullptr,
+        nullptr,
+        v.elementType,
+        v.numItems[0],
+        v.numItems[1],
+        v.numItems[2]);
+  default:
+    return anariNewArray1D(
+        device, nullptr, nullptr, nullptr, v.elementType, v.elementCount);
+  }
+}
+
+// Read the payload of the peeked array record 'v' into the pooled array of its
+// name, creating (or replacing) it if the type or dimensions changed
+static int uploadArray(
+    AGXAnariBinding_t *b, AGXReader r, const AGXParamView &v)
+{
+  auto it = b->arrays.find(b->name);
+  if (it == b->arrays.end())
+    it = b->arrays.emplace(b->name, AGXPooledArray{}).first;
+  AGXPooledArray &pooled = it->second;
+
+  const bool reuse = pooled.array && pooled.elementType == v.elementType
+      && pooled.dimensions == v.dimensions
+      && std::memcmp(pooled.numItems, v.numItems, sizeof(v.numItems)) == 0;
+  if (!reuse) {
+    ANARIArray array = newArray(b->device, v);
+    if (!array)
+      return 3;
+    ANARIDataType type = ANARI_ARRAY1D;
+    if (v.dimensions == 2)
+      type = ANARI_ARRAY2D;
+    else if (v.dimensions == 3)
+      type = ANARI_ARRAY3D;
+    anariSetParameter(b->device, b->object, b->name.c_str(), type, &array);
+    if (pooled.array)
+      anariRelease(b->device, pooled.array);
+    pooled.array = array;
+    pooled.elementType = v.elementType;
+    pooled.dimensions = v.dimensions;
+    std::memcpy(pooled.numItems, v.numItems, sizeof(v.numItems));
+    b->stats.arraysCreated++;
+  } else {
+    b->stats.arraysReused++;
+  }
+
+  if (v.dataBytes == 0)
+    return agxReaderReadPayload(r, nullptr, 0) == 0 ? 0 : 2;
+
+  void *dst = anariMapArray(b->device, pooled.array);
+  if (!dst)
+    return 3;
+  const int rc = agxReaderReadPayload(r, dst, v.dataBytes);
+  anariUnmapArray(b->device, pooled.array);
+  if (rc != 0)
+    return 2;
+  b->stats.bytesUploaded += v.dataBytes;
+  return 0;
+}
+
+// Set a single value record (read in full by 'next') on the object
+static int setValue(AGXAnariBinding_t *b, AGXReader r, AGXRecordFn next)
+{
+  AGXParamView v{};
+  if (next(r, &v) != 1)
+    return 2;
+  if (v.type == ANARI_STRING) {
+    b->value.assign(
+        static_cast<const char *>(v.data), static_cast<size_t>(v.dataBytes));
+    anariSetParameter(
+        b->device, b->object, b->name.c_str(), ANARI_STRING, b->value.c_str());
+  } else if (!anari::isObject(v.type) && v.data) {
+    anariSetParameter(b->device, b->object, b->name.c_str(), v.type, v.data);
+  }
+  return 0;
+}
+
+// Set the remaining records of the current section of 'r' and commit
+static int setRecords(
+    AGXAnariBinding_t *b, AGXReader r, AGXRecordFn peek, AGXRecordFn next)
+{
+  AGXParamView v{};
+  int rc = 0;
+  while ((rc = peek(r, &v)) == 1) {
+    b->name.assign(v.name, v.nameLength);
+    if (!v.isArray)
+      rc = setValue(b, r, next);
+    else if (isPlainDataType(v.elementType))
+      rc = uploadArray(b, r, v);
+    else
+      rc = next(r, &v) == 1 ? 0 : 2; // handles can't be restored, skip
+    if (rc != 0)
+      return rc;
+  }
+  if (rc < 0)
+    return 2;
+  anariCommitParameters(b->device, b->object);
+  return 0;
+}
+
+extern "C" {
+
+AGXAnariBinding agxNewAnariBinding(ANARIDevice device, ANARIObject object)
+{
+  if (!device || !object)
+    return nullptr;
+  AGXAnariBinding_t *b = new AGXAnariBinding_t();
+  b->device = device;
+  b->object = object;
+  return b;
+}
+
+void agxReleaseAnariBinding(AGXAnariBinding b)
+{
+  if (!b)
+    return;
+  for (auto &entry : b->arrays) {
+    if (entry.second.array)
+      anariRelease(b->device, entry.second.array);
+  }
+  delete b;
+}
+
+int agxAnariSetConstants(AGXAnariBinding b, AGXReader r)
+{
+  if (!b || !r)
+    return 1;
+  agxReaderResetConstants(r);
+  return setRecords(b, r, agxReaderPeekConstant, agxReaderNextConstant);
+}
+
+int agxAnariSetTimeStep(AGXAnariBinding b, AGXReader r, uint32_t timeStep)
+{
+  if (!b || !r || agxReaderSeekTimeStep(r, timeStep) != 0)
+    return 1;
+  uint32_t index = 0;
+  uint32_t count = 0;
+  if (agxReaderBeginNextTimeStep(r, &index, &count) != 1)
+    return 2;
+  return setRecords(
+      b, r, agxReaderPeekTimeStepParam, agxReaderNextTimeStepParam);
+}
+
+int agxAnariGetStats(AGXAnariBinding b, AGXAnariStats *out)
+{
+  if (!b || !out)
+    return 1;
+  *out = b->stats;
+  return 0;
+}
+
+} // extern "C"
+#endif
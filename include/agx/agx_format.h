@@ -0,0 +1,62 @@
+// Copyright 2025 Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// Format-level constants shared by agx_read.h and agx_write.h. The file layout
+// itself is documented at the top of agx_write.h.
+
+#include <stdint.h>
+
+// Parameter record flags (the byte following the record name; v1/v2 files only
+// ever use AGX_RECORD_FLAG_ARRAY)
+#define AGX_RECORD_FLAG_ARRAY 0x01u // array record, otherwise a single value
+#define AGX_RECORD_FLAG_ENCODED 0x02u // array payload is compressed (v3+)
+#define AGX_RECORD_FLAG_DELTA 0x04u // array is a delta to an earlier one (v4+)
+#define AGX_RECORD_FLAG_REF 0x08u // array repeats an earlier record (v5+)
+#define AGX_RECORD_FLAG_CHUNKED 0x10u // array is stored in chunks (v6+)
+#define AGX_RECORD_FLAG_ALIGNED 0x20u // array payload is padded (v7+)
+#define AGX_RECORD_FLAG_QUANTIZED 0x40u // array is stored quantized (v9+)
+#define AGX_RECORD_FLAG_SHAPED 0x80u // array has 2 or 3 dimensions (v10+)
+#define AGX_RECORD_KNOWN_FLAGS                                                 \
+  (AGX_RECORD_FLAG_ARRAY | AGX_RECORD_FLAG_ENCODED | AGX_RECORD_FLAG_DELTA     \
+      | AGX_RECORD_FLAG_REF | AGX_RECORD_FLAG_CHUNKED                          \
+      | AGX_RECORD_FLAG_ALIGNED | AGX_RECORD_FLAG_QUANTIZED                    \
+      | AGX_RECORD_FLAG_SHAPED)
+
+// Delta modes of AGX_RECORD_FLAG_DELTA records
+#define AGX_DELTA_XOR 1u // payload = data ^ base
+#define AGX_DELTA_ADD 2u // payload = data - base, per (unsigned) lane
+#define AGX_DELTA_COPY 3u // data == base, no payload
+
+// Array payload compression codecs
+typedef enum AGXCodec
+{
+  AGX_CODEC_NONE = 0,
+  AGX_CODEC_LZ4 = 1,
+  AGX_CODEC_ZSTD = 2
+} AGXCodec;
+
+// Lossy array encodings (agxSetArrayQuantization) of ANARI_FLOAT32 arrays and
+// their VEC2..VEC4 forms, with the element type they are stored as
+typedef enum AGXQuantization
+{
+  AGX_QUANTIZE_NONE = 0,
+  AGX_QUANTIZE_FLOAT16 = 1, // half floats (ANARI_FLOAT16_VECn)
+  AGX_QUANTIZE_OCT16 = 2, // VEC3 unit vectors, octahedral (ANARI_FIXED16_VEC2)
+  AGX_QUANTIZE_BOUNDS16 = 3 // per-component [min, max] (ANARI_UFIXED16_VECn)
+} AGXQuantization;
+
+// File I/O backends of the exporter and reader
+typedef enum AGXIOBackend
+{
+  AGX_IO_STDIO = 0, // buffered stdio / memory mapping (portable default)
+  AGX_IO_DIRECT = 1 // O_DIRECT with several requests in flight (Linux)
+} AGXIOBackend;
+
+// Trace hooks (agxReaderSetTraceHooks / agxExporterSetTraceHooks), called on
+// the thread doing the work when a phase begins and ends. 'name' is a string
+// literal identifying the phase (e.g. "agx.read.payload"), so its address can
+// serve as a key.
+typedef void (*AGXTraceBeginCallback)(const void *userData, const char *name);
+typedef void (*AGXTraceEndCallback)(const void *userData, const char *name);
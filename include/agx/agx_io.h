@@ -0,0 +1,494 @@
+// Copyright 2025 Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// agx_io.h - I/O instrumentation and the direct I/O backend (AGX_IO_DIRECT)
+// shared by the reader and exporter implementations. Only included from the
+// AGX_READ_IMPL / AGX_WRITE_IMPL sections of agx_read.h and agx_write.h.
+//
+// Direct I/O: files are transferred in aligned blocks with O_DIRECT, bypassing
+// the page cache. A small pool of threads runs the pread()/pwrite() calls, so
+// several requests are in flight at once -- the portable, blocking counterpart
+// of an io_uring submission queue.
+
+#include "agx_format.h"
+// std
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Instrumentation ////////////////////////////////////////////////////////////
+
+struct AGXTraceHooks
+{
+  AGXTraceBeginCallback begin{nullptr};
+  AGXTraceEndCallback end{nullptr};
+  const void *userData{nullptr};
+};
+
+// Adds its lifetime to '*seconds' and reports it to the trace hooks as phase
+// 'name'. Does nothing with seconds = nullptr (uninstrumented code paths).
+struct AGXPhaseTimer
+{
+  const AGXTraceHooks *hooks{nullptr};
+  const char *name{nullptr};
+  double *seconds{nullptr};
+  std::chrono::steady_clock::time_point start;
+
+  AGXPhaseTimer(const AGXTraceHooks *h, const char *phase, double *s)
+      : hooks(h), name(phase), seconds(s)
+  {
+    if (!seconds)
+      return;
+    if (hooks && hooks->begin)
+      hooks->begin(hooks->userData, name);
+    start = std::chrono::steady_clock::now();
+  }
+
+  AGXPhaseTimer(const AGXPhaseTimer &) = delete;
+  AGXPhaseTimer &operator=(const AGXPhaseTimer &) = delete;
+
+  ~AGXPhaseTimer()
+  {
+    stop();
+  }
+
+  // End the phase before the timer goes out of scope
+  void stop()
+  {
+    if (!seconds)
+      return;
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    *seconds += std::chrono::duration<double>(elapsed).count();
+    seconds = nullptr;
+    if (hooks && hooks->end)
+      hooks->end(hooks->userData, name);
+  }
+};
+
+// Direct I/O /////////////////////////////////////////////////////////////////
+
+#if defined(__linux__)
+#define AGX_HAS_DIRECT_IO 1
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+// std
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Offsets, sizes and memory of all direct requests are multiples of this
+static const size_t AGX_DIRECT_ALIGNMENT = 4096;
+static const unsigned AGX_DIRECT_QUEUE_DEPTH = 8; // requests in flight
+static const size_t AGX_DIRECT_BLOCK_BYTES = size_t(1) << 20; // per write
+// Reads are smaller, so random accesses (seeks, headers) stay cheap
+static const size_t AGX_DIRECT_READ_BLOCK_BYTES = size_t(1) << 18;
+static const unsigned AGX_DIRECT_READ_SLOTS = 16; // cached blocks
+
+// One pread() or pwrite() of a block
+struct AGXIORequest
+{
+  uint8_t *data{nullptr};
+  size_t size{0};
+  uint64_t offset{0};
+  bool write{false};
+  bool done{true};
+  bool ok{true};
+  size_t transferred{0}; // reads stop early at the end of the file
+};
+
+// Threads carrying out the requests submitted for one file descriptor
+struct AGXIOQueue
+{
+  int fd{-1};
+  std::mutex mutex;
+  std::condition_variable submitted;
+  std::condition_variable completed;
+  std::deque<AGXIORequest *> pending;
+  std::vector<std::thread> threads;
+  bool stop{false};
+
+  AGXIOQueue() = default;
+  AGXIOQueue(const AGXIOQueue &) = delete;
+  AGXIOQueue &operator=(const AGXIOQueue &) = delete;
+  ~AGXIOQueue()
+  {
+    shutdown();
+  }
+
+  void start(int fileDescriptor)
+  {
+    fd = fileDescriptor;
+    for (unsigned i = 0; i < AGX_DIRECT_QUEUE_DEPTH; ++i)
+      threads.emplace_back([this]() { run(); });
+  }
+
+  void shutdown()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    submitted.notify_all();
+    for (auto &t : threads)
+      t.join();
+    threads.clear();
+  }
+
+  void submit(AGXIORequest &q)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      q.done = false;
+      q.ok = true;
+      q.transferred = 0;
+      pending.push_back(&q);
+    }
+    submitted.notify_one();
+  }
+
+  // Block until 'q' (if submitted) has completed; returns whether it succeeded
+  bool wait(AGXIORequest &q)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    completed.wait(lock, [&]() { return q.done; });
+    return q.ok;
+  }
+
+  void run()
+  {
+    for (;;) {
+      AGXIORequest *q = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        submitted.wait(lock, [&]() { return stop || !pending.empty(); });
+        if (pending.empty())
+          return;
+        q = pending.front();
+        pending.pop_front();
+      }
+      transfer(*q);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        q->done = true;
+      }
+      completed.notify_all();
+    }
+  }
+
+  void transfer(AGXIORequest &q)
+  {
+    while (q.transferred < q.size) {
+      const off_t at = static_cast<off_t>(q.offset + q.transferred);
+      uint8_t *p = q.data + q.transferred;
+      const size_t n = q.size - q.transferred;
+      const ssize_t got =
+          q.write ? ::pwrite(fd, p, n, at) : ::pread(fd, p, n, at);
+      if (got < 0 && errno == EINTR)
+        continue;
+      if (got < 0 || (got == 0 && q.write)) {
+        q.ok = false;
+        return;
+      }
+      if (got == 0)
+        return; // end of file
+      q.transferred += static_cast<size_t>(got);
+    }
+  }
+};
+
+static uint8_t *allocateDirectBlock(size_t bytes)
+{
+  void *p = nullptr;
+  if (::posix_memalign(&p, AGX_DIRECT_ALIGNMENT, bytes) != 0)
+    return nullptr;
+  return static_cast<uint8_t *>(p);
+}
+
+// Sequential output through a ring of aligned blocks, each written as soon as
+// it is full while the next ones are filled
+struct AGXDirectWriter
+{
+  int fd{-1};
+  AGXIOQueue queue;
+  uint8_t *blocks[AGX_DIRECT_QUEUE_DEPTH] = {};
+  AGXIORequest requests[AGX_DIRECT_QUEUE_DEPTH];
+  unsigned current{0};
+  size_t fill{0};
+  uint64_t offset{0}; // file offset of the current block
+  bool ok{true};
+
+  AGXDirectWriter() = default;
+  AGXDirectWriter(const AGXDirectWriter &) = delete;
+  AGXDirectWriter &operator=(const AGXDirectWriter &) = delete;
+  ~AGXDirectWriter()
+  {
+    queue.shutdown();
+    for (uint8_t *b : blocks)
+      std::free(b);
+    if (fd >= 0)
+      ::close(fd);
+  }
+
+  // Returns false if the file can't be opened for direct I/O (e.g. the file
+  // system doesn't support it)
+  bool open(const char *filename)
+  {
+    fd = ::open(
+        filename, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT | O_CLOEXEC, 0666);
+    if (fd < 0)
+      return false;
+    for (auto &b : blocks) {
+      b = allocateDirectBlock(AGX_DIRECT_BLOCK_BYTES);
+      if (!b)
+        return false;
+    }
+    queue.start(fd);
+    return true;
+  }
+
+  bool write(const void *data, size_t n)
+  {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    while (ok && n > 0) {
+      const size_t m = std::min(n, AGX_DIRECT_BLOCK_BYTES - fill);
+      std::memcpy(blocks[current] + fill, p, m);
+      fill += m;
+      p += m;
+      n -= m;
+      if (fill == AGX_DIRECT_BLOCK_BYTES)
+        submitCurrent(AGX_DIRECT_BLOCK_BYTES);
+    }
+    return ok;
+  }
+
+  // Write out the partial last block, wait for all requests, and trim the
+  // file to 'size' bytes. The descriptor stays open in buffered mode, for
+  // small in-place patches.
+  bool finish(uint64_t size)
+  {
+    if (ok && fill > 0) {
+      const size_t padded = (fill + AGX_DIRECT_ALIGNMENT - 1)
+          & ~(AGX_DIRECT_ALIGNMENT - 1);
+      std::memset(blocks[current] + fill, 0, padded - fill);
+      submitCurrent(padded);
+    }
+    for (auto &q : requests)
+      ok = queue.wait(q) && ok;
+    queue.shutdown();
+    ok = ok && ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+    const int flags = ::fcntl(fd, F_GETFL);
+    ok = ok && flags >= 0 && ::fcntl(fd, F_SETFL, flags & ~O_DIRECT) == 0;
+    return ok;
+  }
+
+  // Overwrite 'n' bytes at file offset 'at' after finish()
+  bool patch(uint64_t at, const void *data, size_t n)
+  {
+    return ::pwrite(fd, data, n, static_cast<off_t>(at))
+        == static_cast<ssize_t>(n);
+  }
+
+  bool close()
+  {
+    const bool closed = ::close(fd) == 0;
+    fd = -1;
+    return closed;
+  }
+
+  void submitCurrent(size_t size)
+  {
+    AGXIORequest &q = requests[current];
+    q.data = blocks[current];
+    q.size = size;
+    q.offset = offset;
+    q.write = true;
+    queue.submit(q);
+    offset += size;
+    fill = 0;
+
+    // Wait for the oldest request before its block is refilled
+    current = (current + 1) % AGX_DIRECT_QUEUE_DEPTH;
+    ok = queue.wait(requests[current]) && ok;
+  }
+};
+
+// Random access input through a cache of aligned blocks. While reading
+// sequentially, the blocks ahead of the current one are kept queued, so the
+// disk stays busy; random reads only load the blocks they touch.
+struct AGXDirectReader
+{
+  struct Slot
+  {
+    uint8_t *data{nullptr};
+    uint64_t block{UINT64_MAX};
+    uint64_t lastUse{0};
+    AGXIORequest request;
+  };
+
+  int fd{-1};
+  bool ownsFd{false};
+  uint64_t size{0};
+  AGXIOQueue queue;
+  Slot slots[AGX_DIRECT_READ_SLOTS];
+  uint64_t tick{0};
+  uint64_t lastBlock{UINT64_MAX}; // of the previous fetch()
+
+  AGXDirectReader() = default;
+  AGXDirectReader(const AGXDirectReader &) = delete;
+  AGXDirectReader &operator=(const AGXDirectReader &) = delete;
+  ~AGXDirectReader()
+  {
+    queue.shutdown();
+    for (auto &s : slots)
+      std::free(s.data);
+    if (ownsFd && fd >= 0)
+      ::close(fd);
+  }
+
+  // Open 'filename', or (filename = nullptr) read the direct descriptor 'dfd'
+  // of another reader
+  bool open(const char *filename, int dfd = -1)
+  {
+    ownsFd = filename != nullptr;
+    fd = filename ? ::open(filename, O_RDONLY | O_DIRECT | O_CLOEXEC) : dfd;
+    struct stat st;
+    if (fd < 0 || ::fstat(fd, &st) != 0)
+      return false;
+    size = static_cast<uint64_t>(st.st_size);
+    queue.start(fd);
+    return true;
+  }
+
+  bool read(uint64_t offset, void *dst, size_t n)
+  {
+    if (n > size || offset > size - n)
+      return false;
+    uint8_t *out = static_cast<uint8_t *>(dst);
+    while (n > 0) {
+      const uint64_t block = offset / AGX_DIRECT_READ_BLOCK_BYTES;
+      Slot *s = fetch(block);
+      if (!s || !queue.wait(s->request))
+        return false;
+      const size_t at =
+          static_cast<size_t>(offset % AGX_DIRECT_READ_BLOCK_BYTES);
+      const size_t m = std::min(n, AGX_DIRECT_READ_BLOCK_BYTES - at);
+      if (at + m > s->request.transferred)
+        return false;
+      std::memcpy(out, s->data + at, m);
+      out += m;
+      offset += m;
+      n -= m;
+    }
+    return true;
+  }
+
+  // The slot holding (or loading) 'block', nullptr if out of memory
+  Slot *fetch(uint64_t block)
+  {
+    const bool sequential = block == lastBlock + 1;
+    lastBlock = block;
+    Slot *s = find(block);
+    if (s)
+      s->lastUse = ++tick;
+    else if (!(s = load(block, nullptr)))
+      return nullptr;
+    if (!sequential)
+      return s;
+
+    const uint64_t blocks =
+        (size + AGX_DIRECT_READ_BLOCK_BYTES - 1) / AGX_DIRECT_READ_BLOCK_BYTES;
+    for (uint64_t b = block + 1;
+         b < blocks && b <= block + AGX_DIRECT_READ_SLOTS / 2;
+         ++b) {
+      if (!find(b) && !load(b, s))
+        break;
+    }
+    return s;
+  }
+
+  Slot *find(uint64_t block)
+  {
+    for (auto &s : slots) {
+      if (s.block == block)
+        return &s;
+    }
+    return nullptr;
+  }
+
+  // Start loading 'block' into the least recently used slot (except 'keep')
+  Slot *load(uint64_t block, const Slot *keep)
+  {
+    Slot *victim = nullptr;
+    for (auto &s : slots) {
+      if (&s != keep && (!victim || s.lastUse < victim->lastUse))
+        victim = &s;
+    }
+    queue.wait(victim->request);
+    if (!victim->data
+        && !(victim->data = allocateDirectBlock(AGX_DIRECT_READ_BLOCK_BYTES)))
+      return nullptr;
+    victim->block = block;
+    victim->lastUse = ++tick;
+    AGXIORequest &q = victim->request;
+    q.data = victim->data;
+    q.size = AGX_DIRECT_READ_BLOCK_BYTES;
+    q.offset = block * AGX_DIRECT_READ_BLOCK_BYTES;
+    q.write = false;
+    queue.submit(q);
+    return victim;
+  }
+};
+
+#else
+// No direct I/O on this platform: opening always fails, so files are read and
+// written with stdio
+struct AGXDirectWriter
+{
+  int fd{-1};
+
+  bool open(const char *)
+  {
+    return false;
+  }
+  bool write(const void *, size_t)
+  {
+    return false;
+  }
+  bool finish(uint64_t)
+  {
+    return false;
+  }
+  bool patch(uint64_t, const void *, size_t)
+  {
+    return false;
+  }
+  bool close()
+  {
+    return false;
+  }
+};
+
+struct AGXDirectReader
+{
+  int fd{-1};
+
+  bool open(const char *, int = -1)
+  {
+    return false;
+  }
+  bool read(uint64_t, void *, size_t)
+  {
+    return false;
+  }
+};
+#endif
@@ -7,6 +7,9 @@
 
 #include <stddef.h>
 #include <stdint.h>
+
+#include "agx_format.h"
+
 // Use ANARI's logical type enums.
 #include <anari/frontend/anari_enums.h>
 #include <anari/frontend/type_utility.h>
@@ -25,17 +28,25 @@ typedef struct AGXHeader
   ANARIDataType objectType;
   uint32_t timeSteps;
   uint32_t constantParamCount;
+  uint32_t partCount; // part files of a split file, 0 for AGXB files
 
   // Endianness info
   uint32_t endianMarker; // value from file
   uint8_t hostLittleEndian; // 1 if host is little-endian
   uint8_t fileLittleEndian; // 1 if file is little-endian
-  uint8_t needByteSwap; // 1 if we need to swap 32/64-bit scalar header fields
+  uint8_t needByteSwap; // 1 if multi-byte fields and payloads are swapped
   uint8_t reserved;
 } AGXHeader;
 
 // A view into a parameter record. The 'data' and 'name' pointers are valid
 // until the next Next* call on the same reader (or the reader is destroyed).
+// For readers opened with agxNewReaderMapped, 'data' points directly into the
+// file mapping and stays valid until the reader is released (except for
+// compressed, delta-encoded or dequantized arrays, which are always decoded
+// into internal buffers). Arrays stored as references to an earlier array with
+// the same content (see agxSetDeduplication) share one buffer -- the mapping,
+// or one decoded for the reader -- which also stays valid until the reader is
+// released (unless they are dequantized).
 typedef struct AGXParamView
 {
   const char *name; // not null-terminated guaranteed; see nameLength
@@ -48,20 +59,79 @@ typedef struct AGXParamView
   // For arrays
   ANARIDataType elementType; // valid when isArray == 1
   uint64_t elementCount; // valid when isArray == 1
+  uint8_t dimensions; // valid when isArray == 1: 1, 2 or 3
+  uint64_t numItems[3]; // elements per dimension (1 past 'dimensions')
 
   // Raw bytes for the value or array contents
-  const void *data; // pointer to internal buffer
+  const void *data; // pointer to internal buffer (or file mapping)
   uint64_t dataBytes; // number of bytes pointed to by 'data'
+
+  uint64_t recordOffset; // file offset of the record (agxReaderReadArrayRange)
+  uint32_t part; // part file of a split file holding the record, else 0
+
+  // Quantized arrays read in their stored form (agxReaderSetDequantize(r, 0);
+  // elementType is then the stored type): the AGXQuantization, and for
+  // AGX_QUANTIZE_BOUNDS16 the range of each component c, which is
+  // boundsMin[c] + q / 65535 * (boundsMax[c] - boundsMin[c]) for the UFIXED16
+  // value q. AGX_QUANTIZE_NONE for all other records, including dequantized
+  // arrays.
+  uint8_t quantization;
+  float boundsMin[4];
+  float boundsMax[4];
 } AGXParamView;
 
 // Open/close
+// Opening only parses the header; the location of the time step section (and
+// the table of contents, if any) is resolved the first time it is needed.
+// Split manifests (agxWriteSplitManifest) are opened the same way, see
+// agxReaderGetPartFilename().
 AGXReader agxNewReader(const char *filename);
 void agxReleaseReader(AGXReader r);
 
+// Open a file by memory-mapping it. Parameter data is not copied: views
+// returned by the iteration functions point straight into the mapping and
+// remain valid for the lifetime of the reader. Returns NULL if the file cannot
+// be opened or mapped on this platform.
+AGXReader agxNewReaderMapped(const char *filename);
+
+// Open a file with the given I/O backend. AGX_IO_DIRECT (Linux) reads with
+// O_DIRECT in aligned 256 KiB blocks, bypassing the page cache, and keeps the
+// blocks ahead queued while reading sequentially; files which can't be opened
+// that way are read with stdio. AGX_IO_STDIO is the same as agxNewReader().
+// Returns NULL on error.
+AGXReader agxNewReaderWithIO(const char *filename, AGXIOBackend backend);
+
 // Header
-// Returns 0 on success; nonzero on error. 'out' is filled on success.
+// Returns 0 on success; nonzero on error. 'out' is filled on success. For
+// split files, version and byte order are those of the manifest, and the
+// constants of all parts are counted (opening each part).
 int agxReaderGetHeader(AGXReader r, AGXHeader *out);
 
+// Byte order
+// Payloads are produced in the byte order they were written in, so files from
+// a host of the other endianness (AGXHeader::needByteSwap) need converting
+// before use. With 'enable' != 0, values and arrays of files needing it are
+// converted to host order as they are read (views then point into an internal
+// buffer, valid until the next Next* call, also for mapped readers). Default
+// off.
+void agxReaderSetConvertByteOrder(AGXReader r, int enable);
+
+// Reverse the byte order of each component of the 'bytes' bytes of 'type'
+// values at 'data', in place (no-op for 1-byte components, strings and
+// object handles).
+void agxSwapBytes(void *data, uint64_t bytes, ANARIDataType type);
+
+// Quantization
+// Arrays stored quantized (agxSetArrayQuantization) are restored to the
+// ANARI_FLOAT32[_VECn] arrays they were written from as they are read, like
+// any other decoding step. With 'enable' == 0, they are produced as stored
+// instead, for decoding on the GPU: half floats (ANARI_FLOAT16_VECn), signed
+// 16-bit octahedral coordinates (ANARI_FIXED16_VEC2; x, y in [-1, 1] and z = 1
+// - |x| - |y|, with x -= copysign(max(-z, 0), x) and the same for y before
+// normalizing) or 16-bit fixed point within the bounds set in the view
+// (ANARI_UFIXED16_VECn). Applies to views produced from then on. Default on.
+void agxReaderSetDequantize(AGXReader r, int enable);
+
 // Get object subtype (as set by writer, or "" if none was set).
 const char *agxReaderGetSubtype(AGXReader r);
 
@@ -90,9 +160,204 @@ int agxReaderNextTimeStepParam(AGXReader r, AGXParamView *out);
 // Optional: skip any remaining parameters in the current time step.
 void agxReaderSkipRemainingTimeStep(AGXReader r);
 
+// Lookup by name
+// Find the constant / the parameter of time step 'timeStep' named 'name'
+// (null-terminated) and read it like the Next* calls would, without moving the
+// iteration position. Each section's record names are indexed on its first
+// lookup by scanning the record headers, skipping all payloads. Returns 1 and
+// fills 'out' if found, 0 if there is no such parameter, -1 on error.
+int agxReaderFindConstant(AGXReader r, const char *name, AGXParamView *out);
+int agxReaderFindTimeStepParam(
+    AGXReader r, uint32_t timeStep, const char *name, AGXParamView *out);
+
+// Two-phase reading
+// Fill 'out' with the metadata of the next constant / time step parameter
+// (data = NULL) without reading its payload. The record stays current: read
+// its payload into caller memory with agxReaderReadPayload(), or the whole
+// record with the matching Next* call. Return values as for the Next* calls.
+int agxReaderPeekConstant(AGXReader r, AGXParamView *out);
+int agxReaderPeekTimeStepParam(AGXReader r, AGXParamView *out);
+
+// Read the payload of the record returned by the last Peek* call into 'dst'
+// ('dstBytes' >= its dataBytes), decoding it as needed, and move on to the
+// next record. Raw and compressed payloads are read or decompressed straight
+// into 'dst'. Returns 0 on success; 1 if there is no peeked record, 2 if
+// 'dst' is too small (the record stays current), 3 on I/O or decode errors.
+int agxReaderReadPayload(AGXReader r, void *dst, uint64_t dstBytes);
+
+// Partial reads
+// Decode elements [firstElement, firstElement + count) of the array 'view' was
+// filled with (by any Next*, Find* or Peek* call on 'r' or a cursor of it)
+// into 'dst' (count * element size bytes), without moving the iteration
+// position. Of chunked arrays (see agxSetArrayChunking), only the chunks the
+// range overlaps are read and decoded; raw arrays are read from the range's
+// offset; others are decoded in full first. Returns 0 on success; 1 on bad
+// arguments (not an array, range out of bounds), 2 on I/O or decode errors.
+int agxReaderReadArrayRange(AGXReader r,
+    const AGXParamView *view,
+    uint64_t firstElement,
+    uint64_t count,
+    void *dst);
+
+// Bricks and slabs of 2D / 3D arrays (agxSetParameterArray2D/3D)
+// Decode the box of elements (x, y, z) with first[d] <= (x, y, z)[d] <
+// first[d] + count[d] of the array 'view' was filled with into 'dst', packed
+// in x-fastest order (count[0] * count[1] * count[2] elements). The box must
+// lie within view->numItems, so for 2D arrays first[2] = 0 and count[2] = 1.
+// Reads like agxReaderReadArrayRange(), one row at a time unless the box spans
+// whole rows (or whole planes: slabs are read as a single range); each chunk
+// is decoded at most once. Return values as for agxReaderReadArrayRange().
+int agxReaderReadArrayBox(AGXReader r,
+    const AGXParamView *view,
+    const uint64_t first[3],
+    const uint64_t count[3],
+    void *dst);
+
+// A box of an array in place: element (x, y, z) of the box is at
+// (const char *)data + x * stride[0] + y * stride[1] + z * stride[2]
+typedef struct AGXArrayBoxView
+{
+  const void *data; // element 'first' of the box
+  uint64_t count[3]; // elements of the box per dimension
+  uint64_t stride[3]; // bytes between neighbouring elements per dimension
+} AGXArrayBoxView;
+
+// Point 'out' at a box of 'view' (as for agxReaderReadArrayBox) inside the
+// file mapping of a reader opened with agxNewReaderMapped, without copying or
+// decoding anything. Possible for arrays stored raw (or deduplicated against
+// one), and not dequantized or byte order converted; elements are as aligned
+// as the writer's agxSetPayloadAlignment() made them. The view stays valid
+// until the reader is released. Returns 0 on success; 1 on bad arguments, 2
+// if the box can't be viewed in place (read it with agxReaderReadArrayBox()
+// instead), 3 on I/O errors.
+int agxReaderViewArrayBox(AGXReader r,
+    const AGXParamView *view,
+    const uint64_t first[3],
+    const uint64_t count[3],
+    AGXArrayBoxView *out);
+
 // Reset time step iteration to the first time step.
 void agxReaderResetTimeSteps(AGXReader r);
 
+// Position the reader so the next agxReaderBeginNextTimeStep() call returns
+// the time step at 'index' (0 <= index < timeSteps). Uses the file's table of
+// contents when present (v2+); older files are scanned once on first use.
+// Returns 0 on success; nonzero on error.
+int agxReaderSeekTimeStep(AGXReader r, uint32_t index);
+
+// Timestamps
+// Time of time step 'index' as set by the writer (agxSetTimeStepTime); files
+// before v8 report the index. Returns 0 on success; nonzero on error.
+int agxReaderGetTimeStepTime(AGXReader r, uint32_t index, double *outTime);
+
+// Find the consecutive time steps bracketing 'time' (binary search over the
+// timestamps, which are loaded with the TOC): time(first) <= time <=
+// time(second), and 'outWeight' = (time - time(first)) / (time(second) -
+// time(first)), i.e. the interpolation weight of 'second'. Times outside the
+// animation clamp to its first / last step (first == second, weight 0).
+// Returns 0 on success; 1 on bad arguments or a file without time steps, 2 on
+// I/O errors.
+int agxReaderFindTimeStepInterval(AGXReader r,
+    double time,
+    uint32_t *outFirst,
+    uint32_t *outSecond,
+    double *outWeight);
+
+// Linearly interpolate the array 'name' between the time steps bracketing
+// 'time' (see agxReaderFindTimeStepInterval) into 'dst' ('dstBytes' >= its
+// dataBytes, aligned for its element type), without moving the iteration
+// position. Both steps must hold it with the same element type and count;
+// supported element types are ANARI_FLOAT32 / ANARI_FLOAT64 and their
+// VEC2..VEC4 forms. Files needing a byte swap require
+// agxReaderSetConvertByteOrder(). Returns 0 on success; 1 on bad arguments
+// (unsupported type, arrays differing between the steps, 'dst' too small), 2
+// if a bracketing step has no such array, 3 on I/O or decode errors.
+int agxReaderInterpolateArray(AGXReader r,
+    const char *name,
+    double time,
+    void *dst,
+    uint64_t dstBytes);
+
+// Cursors
+// Create an independent handle on the same open file, with its own position,
+// iteration state and scratch buffers, meant for reading different parts of
+// the file from different threads. The parsed header, table of contents and
+// time step index are copied from 'r' (locating all time steps first if
+// needed); data is read with pread() from the descriptor of 'r', or straight
+// from its mapping, so the file is not reopened (except on Windows, where
+// cursors of stdio readers open their own handle). A reader and each of its
+// cursors may be used concurrently, but each by one thread at a time. Release
+// cursors with agxReleaseReader() before the reader they were created from.
+// Returns NULL on error.
+AGXReader agxReaderNewCursor(AGXReader r);
+
+// Split files
+// A reader of a split manifest presents its parts as one file: the constants
+// of all parts in part order, then each time step as the records of every
+// part covering it, again in part order ('part' in the views tells them
+// apart, e.g. the pieces of different ranks with the same name). Find* calls
+// return the first match in part order. Parts are opened with the manifest's
+// backend when first needed -- iterating or finding constants opens all,
+// reading a time step only the parts covering it -- and must have the time
+// step count the manifest gives them. Settings such as byte order conversion
+// apply to all parts, and each part prefetches on a thread of its own. Cursors
+// reopen the manifest and open their own parts. agxReaderGetStats() adds up
+// the counters of the parts opened so far.
+// Returns the path of part 'part' as resolved against the manifest's
+// directory, or NULL if 'r' is not a split file or has fewer parts.
+const char *agxReaderGetPartFilename(AGXReader r, uint32_t part);
+
+// Asynchronous prefetching
+// Load time steps [first, first + count) on a background thread, so that
+// iterating over them later is served from memory instead of waiting for the
+// disk (for mapped readers, their pages are faulted in). Replaces the previous
+// request: loaded steps which are still in range are kept, all others are
+// dropped, so at most 'count' steps are held at a time. Each loaded step is
+// handed over to the iteration functions once and freed when the next one
+// begins. count = 0 cancels prefetching. Returns 0 on success; nonzero on
+// error (1 bad reader, 2 'first' out of range, 3 I/O error).
+int agxReaderPrefetch(AGXReader r, uint32_t first, uint32_t count);
+
+// Returns 1 if time step 'index' is loaded, 0 if it is still queued or being
+// loaded, -1 if it is not prefetched (never requested, dropped, failed to
+// load or already read).
+int agxReaderPrefetchPoll(AGXReader r, uint32_t index);
+
+// Like agxReaderPrefetchPoll(), but blocks while the result would be 0.
+int agxReaderPrefetchWait(AGXReader r, uint32_t index);
+
+// Statistics
+// Counters and wall time of one reader (cursors keep their own), accumulated
+// since it was opened or agxReaderResetStats() was last called.
+typedef struct AGXReaderStats
+{
+  uint64_t bytesRead; // from the file, mapping or prefetched blocks
+  uint64_t recordsParsed; // record headers read
+  uint64_t recordsSkipped; // records passed over without their payload
+  uint64_t bytesSkipped; // stored payload bytes of the skipped records
+  uint64_t scratchReallocations; // payload scratch buffer growths
+
+  // Wall time per phase (seconds); decoding is part of reading payloads
+  double openSeconds; // parsing the header (agxNewReader*)
+  double locateSeconds; // loading the TOC or scanning for time steps
+  double payloadSeconds; // reading payloads ("agx.read.payload")
+  double decodeSeconds; // decompression, deltas, byte order conversion
+  double prefetchWaitSeconds; // waiting for the prefetch thread
+} AGXReaderStats;
+
+// Returns 0 on success; nonzero on error. 'out' is filled on success.
+int agxReaderGetStats(AGXReader r, AGXReaderStats *out);
+void agxReaderResetStats(AGXReader r);
+
+// Call 'begin' and 'end' around each timed phase of 'r' ("agx.read.open",
+// "agx.read.locate", "agx.read.payload", "agx.read.decode",
+// "agx.read.prefetchWait"; decode nests in payload), e.g. to show them in a
+// profiler. NULL callbacks remove the hooks. Cursors start without hooks.
+void agxReaderSetTraceHooks(AGXReader r,
+    AGXTraceBeginCallback begin,
+    AGXTraceEndCallback end,
+    const void *userData);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -102,37 +367,235 @@ void agxReaderResetTimeSteps(AGXReader r);
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifdef AGX_READ_IMPL
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+// byte swapping, interpolation and dequantization kernels
+#if defined(__SSSE3__) || defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+// compression
+#ifdef AGX_WITH_LZ4
+#include <lz4.h>
+#endif
+#ifdef AGX_WITH_ZSTD
+#include <zstd.h>
+#endif
+// std
+#include <algorithm>
+#include <cerrno>
 #include <climits>
+#include <cmath>
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
+#include <memory>
+#include <mutex>
 #include <new>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
+// direct I/O backend
+#include "agx_io.h"
+
+// Newest file format version this reader understands
+static const uint32_t AGX_READER_MAX_VERSION = 10;
+
+// Newest split manifest version this reader understands
+static const uint32_t AGX_READER_MAX_MANIFEST_VERSION = 1;
+
+// Location of a record or time step block in the file
+struct AGXRecordLocation
+{
+  uint64_t offset{0};
+  uint64_t size{0};
+};
+
+// Parsed parameter record header (everything up to the payload)
+struct AGXRecordInfo
+{
+  uint32_t nameLen{0};
+  uint8_t flags{0};
+  uint32_t type{0}; // value type, or element type for arrays
+  uint64_t elementCount{0};
+  uint64_t dataBytes{0}; // decoded payload size
+  uint8_t codec{AGX_CODEC_NONE};
+  uint64_t storedBytes{0}; // payload size in the file
+  uint8_t deltaMode{0};
+  uint8_t laneBytes{0};
+  uint64_t baseOffset{0};
+  uint64_t refOffset{0};
+  uint64_t chunkElements{0}; // elements per chunk of CHUNKED arrays
+  uint64_t chunkCount{0};
+  uint64_t chunkIndexOffset{0}; // file offset of the chunk sizes
+  uint8_t quantization{AGX_QUANTIZE_NONE}; // of QUANTIZED arrays
+  float boundsMin[4]{};
+  float boundsMax[4]{};
+  uint8_t dimensions{1}; // of arrays
+  uint64_t numItems[3]{0, 1, 1};
+};
+
+// Record offsets by name of one section (the constants or a time step)
+struct AGXNameIndex
+{
+  bool built{false};
+  std::unordered_map<std::string, uint64_t> offsets;
+};
+
+// Most recently decoded delta-encoded array of a given name
+struct AGXDecodedArray
+{
+  bool valid{false};
+  uint64_t recordOffset{0};
+  std::vector<uint8_t> bytes;
+};
+
+// A time step block loaded by the prefetch thread
+struct AGXPrefetchSlot
+{
+  enum State
+  {
+    EMPTY,
+    QUEUED,
+    LOADING,
+    READY,
+    FAILED
+  };
+
+  State state{EMPTY};
+  bool dropped{false}; // LOADING, but no longer requested
+  uint32_t step{0};
+  uint64_t offset{0};
+  uint64_t size{0};
+  std::vector<uint8_t> bytes; // block contents (stdio readers)
+};
+
+// Background loading of time step blocks (agxReaderPrefetch). Slots are only
+// touched with 'mutex' held, except for the bytes of a LOADING slot, which
+// belong to the worker.
+struct AGXPrefetcher
+{
+  std::string filename; // opened separately by the worker (stdio readers)
+  const uint8_t *map{nullptr};
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable changed;
+  bool stop{false};
+  std::vector<std::unique_ptr<AGXPrefetchSlot>> slots;
+};
+
+// Part file of a split file
+struct AGXReaderPart
+{
+  std::string filename; // resolved against the manifest's directory
+  uint32_t firstTimeStep{0};
+  uint32_t timeStepCount{0};
+  AGXReader_t *reader{nullptr}; // opened on first use
+};
+
+// State of a reader of a split manifest. The manifest itself is parsed when
+// the reader is opened (header, subtype and timestamps); everything else is
+// read from the parts.
+struct AGXSplitFile
+{
+  bool mapped{false}; // backend the parts are opened with
+  AGXIOBackend backend{AGX_IO_STDIO};
+  bool constantsCounted{false}; // AGXHeader::constantParamCount is known
+  std::vector<AGXReaderPart> parts;
+
+  // Iteration: the part whose constants are read next (reset to its first
+  // constant once reached), the parts covering the current time step and the
+  // one being read, and the part of the record returned by the last Peek*
+  uint32_t constantPart{0};
+  bool constantPartReset{false};
+  std::vector<uint32_t> stepParts;
+  size_t stepPart{0};
+  uint32_t peekPart{UINT32_MAX};
+
+  ~AGXSplitFile()
+  {
+    for (auto &p : parts)
+      agxReleaseReader(p.reader);
+  }
+};
 
 struct AGXReader_t
 {
   std::FILE *f{nullptr};
+  std::string filename;
+
+  // Cursors (agxReaderNewCursor) of stdio readers read the parent's file
+  // descriptor with pread() at their own position 'fdPos'; cursors of mapped
+  // readers share the parent's mapping
+  const AGXReader_t *parent{nullptr};
+  int fd{-1};
+  uint64_t fdPos{0};
+
+  // AGX_IO_DIRECT readers and their cursors read 'fd' through this cache of
+  // aligned blocks (only the reader's own one closes it); 'f' is unused
+  std::unique_ptr<AGXDirectReader> direct;
+
+  // Memory mapping (agxNewReaderMapped); when set, 'f' is unused
+  const uint8_t *map{nullptr};
+  uint64_t mapSize{0};
+  uint64_t mapPos{0};
+#ifdef _WIN32
+  HANDLE mapFile{INVALID_HANDLE_VALUE};
+  HANDLE mapHandle{nullptr};
+#endif
 
   // Endianness
   bool hostLittle{true};
   bool fileLittle{true};
   bool needSwap{false};
+  bool convertByteOrder{false}; // convert payloads to host order (needSwap)
+  std::vector<uint8_t> swapScratch; // converted payloads read elsewhere
+  bool dequantize{true}; // restore quantized arrays (agxReaderSetDequantize)
+  std::vector<uint8_t> quantScratch; // dequantized / stored quantized arrays
 
   // Header info
   AGXHeader hdr{};
 
+  // Set for split manifests, whose calls are forwarded to the parts
+  std::unique_ptr<AGXSplitFile> split;
+
   // Optional subtype
   std::string subtype;
 
   // Offsets
-  long constantsStart{-1}; // file position right after header
-  long timeStepsStart{-1}; // file position at first time step header
+  uint64_t constantsStart{0}; // file position right after header
+  uint64_t timeStepsStart{0}; // file position at first time step header
+
+  // Lazily resolved on first use of the time step section
+  bool timeStepsStartKnown{false};
+  bool tocLoaded{false}; // TOC lookup attempted (hasToc tells if it succeeded)
+
+  // Table of contents (v2+ footer) or step index built by a one-time scan
+  bool hasToc{false};
+  bool stepIndexBuilt{false};
+  std::vector<AGXRecordLocation> constantRecords; // only filled from a TOC
+  std::vector<AGXRecordLocation> stepRecords;
+  std::vector<double> stepTimes; // timestamps, resolved on first use
 
   // Iteration state for constants
   uint32_t constantsRead{0};
 
   // Iteration state for time steps
   uint32_t stepsRead{0};
+  bool stepsPending{true}; // cursor not yet positioned at the time steps
   bool inStep{false};
   uint32_t curStepIndex{0};
   uint32_t curStepParamCount{0};
@@ -141,6 +604,43 @@ struct AGXReader_t
   // Scratch storage for last produced parameter
   std::string lastName;
   std::vector<uint8_t> lastData;
+  std::vector<uint8_t> lastEncoded; // compressed payload (stdio readers)
+  std::vector<uint64_t> chunkOffsets; // payload offsets of the last chunk index
+  std::vector<uint8_t> chunkScratch; // partially needed decoded chunk
+  uint64_t chunkScratchPayload{UINT64_MAX}; // payload offset and index of the
+  uint64_t chunkScratchIndex{0}; // chunk in chunkScratch
+  std::vector<uint8_t> rangeScratch; // fully decoded array for range reads
+
+  // Delta-encoded arrays: last decoded result per name, plus delta staging
+  std::unordered_map<std::string, AGXDecodedArray> deltaCache;
+  std::vector<uint8_t> deltaScratch;
+
+  // Decoded targets of deduplicated (AGX_RECORD_FLAG_REF) arrays by record
+  // offset, kept for the reader's lifetime so all references share them
+  std::unordered_map<uint64_t, std::vector<uint8_t>> refCache;
+
+  // Name lookup tables, built per section on first use
+  AGXNameIndex constantNames;
+  std::vector<AGXNameIndex> stepNames;
+
+  // Record whose header was returned by a Peek* call, positioned at its
+  // payload
+  bool peeked{false};
+  bool peekedConstant{false};
+  uint64_t peekOffset{0}; // record start
+  AGXRecordInfo peekInfo;
+
+  // Prefetched time step block being read (stdio readers): reads of file
+  // positions inside it are served from memory
+  std::unique_ptr<AGXPrefetcher> prefetch;
+  std::vector<uint8_t> window;
+  uint64_t windowStart{0};
+  uint64_t windowPos{0};
+  bool inWindow{false};
+
+  // Instrumentation (agxReaderGetStats / agxReaderSetTraceHooks)
+  AGXReaderStats stats{};
+  AGXTraceHooks trace;
 
   // Helpers to keep name pointer stable
   AGXParamView view{};
@@ -169,310 +669,2488 @@ static uint64_t bswap64(uint64_t v)
       | ((v & 0xFF00000000000000ull) >> 56);
 }
 
-static bool readBytes(std::FILE *f, void *dst, size_t n)
+static uint16_t bswap16(uint16_t v)
 {
-  return std::fread(dst, 1, n, f) == n;
+  return static_cast<uint16_t>((v << 8) | (v >> 8));
 }
 
-static bool readU8(std::FILE *f, uint8_t &v)
+static uint8_t bswapValue(uint8_t v)
 {
-  return readBytes(f, &v, 1);
+  return v;
 }
 
-static bool readU32(std::FILE *f, uint32_t &v, bool swap)
+static uint16_t bswapValue(uint16_t v)
 {
-  if (!readBytes(f, &v, sizeof(v)))
-    return false;
-  if (swap)
-    v = bswap32(v);
-  return true;
+  return bswap16(v);
 }
 
-static bool readU64(std::FILE *f, uint64_t &v, bool swap)
+static uint32_t bswapValue(uint32_t v)
 {
-  if (!readBytes(f, &v, sizeof(v)))
-    return false;
-  if (swap)
-    v = bswap64(v);
-  return true;
+  return bswap32(v);
 }
 
-static bool skipBytes(std::FILE *f, uint64_t n)
+static uint64_t bswapValue(uint64_t v)
 {
-  // Attempt to fseek; if that fails (very large), fall back to buffered skip.
-  if (n <= static_cast<uint64_t>(LONG_MAX)) {
-    if (std::fseek(f, static_cast<long>(n), SEEK_CUR) == 0)
-      return true;
-  }
-  const size_t bufSize = 64 * 1024;
-  std::vector<uint8_t> buf(bufSize);
-  uint64_t remaining = n;
-  while (remaining > 0) {
-    size_t chunk =
-        static_cast<size_t>(remaining > bufSize ? bufSize : remaining);
-    size_t readCount = std::fread(buf.data(), 1, chunk, f);
-    if (readCount != chunk)
-      return false;
-    remaining -= readCount;
-  }
-  return true;
+  return bswap64(v);
 }
 
-// Read a parameter record into reader's scratch storage and produce a view
-static bool readParamRecord(AGXReader_t *r, AGXParamView *out)
+// Width of the components of 'type' which byte order applies to (2, 4 or 8),
+// or 0 if there is nothing to swap
+static size_t swapLaneBytes(ANARIDataType type)
 {
-  uint32_t nameLen = 0;
-  if (!readU32(r->f, nameLen, r->needSwap))
-    return false;
-
-  r->lastName.resize(nameLen);
-  if (nameLen > 0 && !readBytes(r->f, r->lastName.data(), nameLen))
-    return false;
-
-  uint8_t isArray = 0;
-  if (!readU8(r->f, isArray))
-    return false;
-
-  r->lastData.clear();
-
-  if (isArray == 0) {
-    uint32_t typeU32 = 0;
-    uint32_t valueBytes = 0;
-    if (!readU32(r->f, typeU32, r->needSwap))
-      return false;
-    if (!readU32(r->f, valueBytes, r->needSwap))
-      return false;
-    r->lastData.resize(valueBytes);
-    if (valueBytes > 0 && !readBytes(r->f, r->lastData.data(), valueBytes))
-      return false;
-
-    out->name = r->lastName.c_str();
-    out->nameLength = nameLen;
-    out->isArray = 0;
-    out->type = static_cast<ANARIDataType>(typeU32);
-    out->elementType = (ANARIDataType)0;
-    out->elementCount = 0;
-    out->data = r->lastData.data();
-    out->dataBytes = valueBytes;
-    return true;
-  } else {
-    uint32_t elemTypeU32 = 0;
-    uint64_t elemCount = 0;
-    uint64_t dataBytes = 0;
-    if (!readU32(r->f, elemTypeU32, r->needSwap))
-      return false;
-    if (!readU64(r->f, elemCount, r->needSwap))
-      return false;
-    if (!readU64(r->f, dataBytes, r->needSwap))
-      return false;
-    r->lastData.resize(static_cast<size_t>(dataBytes));
-    if (dataBytes > 0
-        && !readBytes(r->f, r->lastData.data(), static_cast<size_t>(dataBytes)))
-      return false;
+  if (type == ANARI_STRING || anari::isObject(type))
+    return 0;
+  const int components = anari::componentsOf(type);
+  if (components <= 0)
+    return 0;
+  const size_t lane = anari::sizeOf(type) / static_cast<size_t>(components);
+  return lane == 2 || lane == 4 || lane == 8 ? lane : 0;
+}
 
-    out->name = r->lastName.c_str();
-    out->nameLength = nameLen;
-    out->isArray = 1;
-    out->type = (ANARIDataType)0;
-    out->elementType = static_cast<ANARIDataType>(elemTypeU32);
-    out->elementCount = elemCount;
-    out->data = r->lastData.data();
-    out->dataBytes = dataBytes;
-    return true;
+template <typename T>
+static void swapLanesScalar(uint8_t *dst, const uint8_t *src, size_t n)
+{
+  for (size_t i = 0; i + sizeof(T) <= n; i += sizeof(T)) {
+    T v;
+    std::memcpy(&v, src + i, sizeof(T));
+    v = bswapValue(v);
+    std::memcpy(dst + i, &v, sizeof(T));
   }
 }
 
-// Skip over a parameter record (used to locate the start of time step section)
-static bool skipParamRecord(AGXReader_t *r)
+// Reverse the byte order of each 'lane'-byte component of 'n' bytes from 'src'
+// into 'dst' (which may be 'src'). Uses the widest byte shuffle the build
+// targets (AVX2, SSSE3, SSE2 shifts, NEON), the scalar loop for the tail.
+static void swapLanes(uint8_t *dst, const uint8_t *src, size_t n, size_t lane)
 {
-  uint32_t nameLen = 0;
-  if (!readU32(r->f, nameLen, r->needSwap))
-    return false;
-  if (!skipBytes(r->f, nameLen))
-    return false;
-
-  uint8_t isArray = 0;
-  if (!readU8(r->f, isArray))
-    return false;
-
-  if (isArray == 0) {
-    uint32_t typeU32 = 0;
-    uint32_t valueBytes = 0;
-    if (!readU32(r->f, typeU32, r->needSwap))
-      return false;
-    if (!readU32(r->f, valueBytes, r->needSwap))
-      return false;
-    if (!skipBytes(r->f, valueBytes))
-      return false;
-    return true;
-  } else {
-    uint32_t elemTypeU32 = 0;
-    uint64_t elemCount = 0;
-    uint64_t dataBytes = 0;
-    if (!readU32(r->f, elemTypeU32, r->needSwap))
-      return false;
-    if (!readU64(r->f, elemCount, r->needSwap))
-      return false;
-    if (!readU64(r->f, dataBytes, r->needSwap))
-      return false;
-    if (!skipBytes(r->f, dataBytes))
-      return false;
-    return true;
+  size_t i = 0;
+#if defined(__SSSE3__) || defined(__AVX2__)
+  const __m128i mask = lane == 2
+      ? _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+      : lane == 4
+      ? _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+      : _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+#if defined(__AVX2__)
+  const __m256i mask256 = _mm256_broadcastsi128_si256(mask);
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    v = _mm256_shuffle_epi8(v, mask256);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+  }
+#endif
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    v = _mm_shuffle_epi8(v, mask);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    if (lane == 8) // swap the 32-bit halves, then as for 4
+      v = _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+    if (lane >= 4) { // swap the 16-bit halves, then as for 2
+      v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+      v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    }
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t v = vld1q_u8(src + i);
+    v = lane == 2 ? vrev16q_u8(v) : lane == 4 ? vrev32q_u8(v) : vrev64q_u8(v);
+    vst1q_u8(dst + i, v);
+  }
+#endif
+  switch (lane) {
+  case 2:
+    swapLanesScalar<uint16_t>(dst + i, src + i, n - i);
+    break;
+  case 4:
+    swapLanesScalar<uint32_t>(dst + i, src + i, n - i);
+    break;
+  case 8:
+    swapLanesScalar<uint64_t>(dst + i, src + i, n - i);
+    break;
+  default:
+    if (dst != src)
+      std::memmove(dst + i, src + i, n - i);
+    break;
   }
 }
 
-extern "C" {
-
-// Open and prime reader: read header and compute section offsets
-AGXReader agxNewReader(const char *filename)
+// dst[i] += t * (b[i] - dst[i]) for 'n' floats, where 'b' needn't be aligned
+// (e.g. a view into a file mapping). Uses AVX, SSE or NEON as the build
+// targets, the scalar loop for the tail.
+static void lerpFloats(float *dst, const uint8_t *b, size_t n, float t)
 {
-  if (!filename)
-    return nullptr;
-  std::FILE *f = std::fopen(filename, "rb");
-  if (!f)
-    return nullptr;
-
-  AGXReader_t *r = new (std::nothrow) AGXReader_t{};
-  if (!r) {
-    std::fclose(f);
-    return nullptr;
+  size_t i = 0;
+#if defined(__AVX__)
+  const __m256 t8 = _mm256_set1_ps(t);
+  for (; i + 8 <= n; i += 8) {
+    const __m256 va = _mm256_loadu_ps(dst + i);
+    const __m256 vb = _mm256_loadu_ps(reinterpret_cast<const float *>(b) + i);
+    _mm256_storeu_ps(
+        dst + i, _mm256_add_ps(va, _mm256_mul_ps(t8, _mm256_sub_ps(vb, va))));
   }
-  r->f = f;
-  r->hostLittle = hostIsLittleEndian();
-
-  // Read header
-  char magic[4];
-  if (!readBytes(r->f, magic, sizeof(magic))
-      || std::memcmp(magic, "AGXB", 4) != 0) {
-    agxReleaseReader(r);
-    return nullptr;
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+  const __m128 t4 = _mm_set1_ps(t);
+  for (; i + 4 <= n; i += 4) {
+    const __m128 va = _mm_loadu_ps(dst + i);
+    const __m128 vb = _mm_loadu_ps(reinterpret_cast<const float *>(b) + i);
+    _mm_storeu_ps(dst + i, _mm_add_ps(va, _mm_mul_ps(t4, _mm_sub_ps(vb, va))));
   }
+#elif defined(__ARM_NEON)
+  for (; i + 4 <= n; i += 4) {
+    const float32x4_t va = vld1q_f32(dst + i);
+    const float32x4_t vb = vreinterpretq_f32_u8(vld1q_u8(b + i * 4));
+    vst1q_f32(dst + i, vaddq_f32(va, vmulq_n_f32(vsubq_f32(vb, va), t)));
+  }
+#endif
+  for (; i < n; ++i) {
+    float vb;
+    std::memcpy(&vb, b + i * sizeof(vb), sizeof(vb));
+    dst[i] += t * (vb - dst[i]);
+  }
+}
 
-  uint32_t version = 0;
-  uint32_t endianMarker = 0;
-  uint32_t objectType = ANARI_UNKNOWN; // default in case of early error
-  uint32_t timeSteps = 0;
-  uint32_t constCount = 0;
-
-  if (!readU32(r->f, version, false) || !readU32(r->f, endianMarker, false)
-      || !readU32(r->f, objectType, false) || !readU32(r->f, timeSteps, false)
-      || !readU32(r->f, constCount, false)) {
-    agxReleaseReader(r);
-    return nullptr;
+// As lerpFloats() for doubles
+static void lerpDoubles(double *dst, const uint8_t *b, size_t n, double t)
+{
+  size_t i = 0;
+#if defined(__AVX__)
+  const __m256d t4 = _mm256_set1_pd(t);
+  for (; i + 4 <= n; i += 4) {
+    const __m256d va = _mm256_loadu_pd(dst + i);
+    const __m256d vb = _mm256_loadu_pd(reinterpret_cast<const double *>(b) + i);
+    _mm256_storeu_pd(
+        dst + i, _mm256_add_pd(va, _mm256_mul_pd(t4, _mm256_sub_pd(vb, va))));
+  }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+  const __m128d t2 = _mm_set1_pd(t);
+  for (; i + 2 <= n; i += 2) {
+    const __m128d va = _mm_loadu_pd(dst + i);
+    const __m128d vb = _mm_loadu_pd(reinterpret_cast<const double *>(b) + i);
+    _mm_storeu_pd(dst + i, _mm_add_pd(va, _mm_mul_pd(t2, _mm_sub_pd(vb, va))));
   }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  for (; i + 2 <= n; i += 2) {
+    const float64x2_t va = vld1q_f64(dst + i);
+    const float64x2_t vb = vreinterpretq_f64_u8(vld1q_u8(b + i * 8));
+    vst1q_f64(dst + i, vaddq_f64(va, vmulq_n_f64(vsubq_f64(vb, va), t)));
+  }
+#endif
+  for (; i < n; ++i) {
+    double vb;
+    std::memcpy(&vb, b + i * sizeof(vb), sizeof(vb));
+    dst[i] += t * (vb - dst[i]);
+  }
+}
 
-  bool fileLittle = true;
-  bool needSwap = false;
-  if (endianMarker == 0x01020304u) {
-    fileLittle = r->hostLittle; // same as host
-    needSwap = false;
-  } else if (bswap32(endianMarker) == 0x01020304u) {
-    fileLittle = !r->hostLittle;
-    needSwap = true;
-  } else {
-    // Invalid endian marker
-    agxReleaseReader(r);
-    return nullptr;
+// Component width of the element types agxReaderInterpolateArray() supports
+// (4 or 8), 0 for others
+static size_t lerpComponentBytes(ANARIDataType type)
+{
+  switch (type) {
+  case ANARI_FLOAT32:
+  case ANARI_FLOAT32_VEC2:
+  case ANARI_FLOAT32_VEC3:
+  case ANARI_FLOAT32_VEC4:
+    return 4;
+  case ANARI_FLOAT64:
+  case ANARI_FLOAT64_VEC2:
+  case ANARI_FLOAT64_VEC3:
+  case ANARI_FLOAT64_VEC4:
+    return 8;
+  default:
+    return 0;
   }
+}
 
-  r->fileLittle = fileLittle;
-  r->needSwap = needSwap;
+// Dequantization kernels (agxSetArrayQuantization): 'src' holds host order
+// 16-bit values, 'dst' receives floats; neither needs to be aligned
 
-  // If needSwap is true, swap the header integers we just read (except
-  // endianMarker which we keep as file value)
-  if (r->needSwap) {
-    version = bswap32(version);
-    timeSteps = bswap32(timeSteps);
-    constCount = bswap32(constCount);
+static float halfToFloat(uint16_t h)
+{
+  // Move exponent and mantissa into place and rebias; infinities and NaNs get
+  // the maximum exponent, subnormals are normalized by subtracting 2^-14
+  uint32_t x = static_cast<uint32_t>(h & 0x7fffu) << 13;
+  const uint32_t exponent = x & 0x0f800000u;
+  x += 0x38000000u;
+  if (exponent == 0x0f800000u)
+    x += 0x38000000u;
+  float f;
+  if (exponent == 0) {
+    x += 0x00800000u;
+    std::memcpy(&f, &x, sizeof(f));
+    f -= 6.103515625e-05f;
+    std::memcpy(&x, &f, sizeof(x));
   }
+  x |= static_cast<uint32_t>(h & 0x8000u) << 16;
+  std::memcpy(&f, &x, sizeof(f));
+  return f;
+}
 
-  r->hdr.version = version;
-  r->hdr.objectType = static_cast<ANARIDataType>(objectType);
-  r->hdr.timeSteps = timeSteps;
-  r->hdr.constantParamCount = constCount;
-  r->hdr.endianMarker = endianMarker;
-  r->hdr.hostLittleEndian = r->hostLittle ? 1 : 0;
-  r->hdr.fileLittleEndian = r->fileLittle ? 1 : 0;
-  r->hdr.needByteSwap = r->needSwap ? 1 : 0;
-  r->hdr.reserved = 0;
-
-  // Read optional subtype string
-  uint32_t subtypeLen = 0;
-  if (!readU32(r->f, subtypeLen, r->needSwap)) {
-    agxReleaseReader(r);
-    return nullptr;
+// 'n' half floats to floats
+static void halfToFloats(uint8_t *dst, const uint8_t *src, size_t n)
+{
+  size_t i = 0;
+#if defined(__F16C__)
+  for (; i + 8 <= n; i += 8) {
+    const __m128i h =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+    _mm256_storeu_ps(
+        reinterpret_cast<float *>(dst + i * 4), _mm256_cvtph_ps(h));
   }
-  if (subtypeLen > 0) {
-    r->subtype.resize(subtypeLen);
-    if (!readBytes(r->f, r->subtype.data(), subtypeLen)) {
-      agxReleaseReader(r);
-      return nullptr;
-    }
-  } else {
-    r->subtype.clear();
+#elif defined(__SSE2__) || defined(_M_X64)
+  // halfToFloat(), four lanes at a time
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i magnitude = _mm_set1_epi32(0x7fff);
+  const __m128i signBit = _mm_set1_epi32(0x8000);
+  const __m128i maxExponent = _mm_set1_epi32(0x0f800000);
+  const __m128i rebias = _mm_set1_epi32(0x38000000);
+  const __m128i one = _mm_set1_epi32(0x00800000);
+  const __m128 subnormal = _mm_set1_ps(6.103515625e-05f);
+  auto convert = [&](__m128i h) {
+    __m128i x = _mm_slli_epi32(_mm_and_si128(h, magnitude), 13);
+    const __m128i exponent = _mm_and_si128(x, maxExponent);
+    const __m128i special = _mm_cmpeq_epi32(exponent, maxExponent);
+    const __m128i small = _mm_cmpeq_epi32(exponent, zero);
+    x = _mm_add_epi32(x, rebias);
+    x = _mm_add_epi32(x, _mm_and_si128(special, rebias));
+    x = _mm_add_epi32(x, _mm_and_si128(small, one));
+    __m128 f = _mm_castsi128_ps(x);
+    f = _mm_sub_ps(f, _mm_and_ps(_mm_castsi128_ps(small), subnormal));
+    const __m128i sign = _mm_slli_epi32(_mm_and_si128(h, signBit), 16);
+    return _mm_or_ps(f, _mm_castsi128_ps(sign));
+  };
+  for (; i + 8 <= n; i += 8) {
+    const __m128i h =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+    float *out = reinterpret_cast<float *>(dst + i * 4);
+    _mm_storeu_ps(out, convert(_mm_unpacklo_epi16(h, zero)));
+    _mm_storeu_ps(out + 4, convert(_mm_unpackhi_epi16(h, zero)));
   }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  for (; i + 4 <= n; i += 4) {
+    const float16x4_t h = vreinterpret_f16_u8(vld1_u8(src + i * 2));
+    vst1q_u8(dst + i * 4, vreinterpretq_u8_f32(vcvt_f32_f16(h)));
+  }
+#endif
+  for (; i < n; ++i) {
+    uint16_t h;
+    std::memcpy(&h, src + i * 2, sizeof(h));
+    const float f = halfToFloat(h);
+    std::memcpy(dst + i * 4, &f, sizeof(f));
+  }
+}
 
-  // Mark constantsStart
-  r->constantsStart = std::ftell(r->f);
-
-  // Compute timeStepsStart by skipping constants
-  for (uint32_t i = 0; i < constCount; ++i) {
-    if (!skipParamRecord(r)) {
-      agxReleaseReader(r);
-      return nullptr;
+// 'count' pairs of snorm16 octahedral coordinates to normalized VEC3 floats.
+// The vector paths decode the last few elements from a zero-padded copy, so
+// an element decodes to the same floats wherever a range read starts.
+static void octToNormals(uint8_t *dst, const uint8_t *src, size_t count)
+{
+#if defined(__SSE2__) || defined(_M_X64)
+  const __m128 scale = _mm_set1_ps(1.0f / 32767.0f);
+  const __m128 minusOne = _mm_set1_ps(-1.0f);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  auto decode4 = [&](uint8_t *out, const uint8_t *in) {
+    const __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+    const __m128i ex = _mm_srai_epi32(_mm_slli_epi32(e, 16), 16);
+    const __m128i ey = _mm_srai_epi32(e, 16);
+    __m128 x = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(ex), scale), minusOne);
+    __m128 y = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(ey), scale), minusOne);
+    const __m128 z = _mm_sub_ps(
+        _mm_sub_ps(one, _mm_and_ps(x, absMask)), _mm_and_ps(y, absMask));
+    const __m128 t = _mm_max_ps(_mm_sub_ps(zero, z), zero);
+    const __m128 xPos = _mm_cmpge_ps(x, zero);
+    const __m128 yPos = _mm_cmpge_ps(y, zero);
+    const __m128 minusT = _mm_sub_ps(zero, t);
+    x = _mm_add_ps(
+        x, _mm_or_ps(_mm_and_ps(xPos, minusT), _mm_andnot_ps(xPos, t)));
+    y = _mm_add_ps(
+        y, _mm_or_ps(_mm_and_ps(yPos, minusT), _mm_andnot_ps(yPos, t)));
+    const __m128 len2 = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+    const __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(len2));
+    float v[3][4];
+    _mm_storeu_ps(v[0], _mm_mul_ps(x, inv));
+    _mm_storeu_ps(v[1], _mm_mul_ps(y, inv));
+    _mm_storeu_ps(v[2], _mm_mul_ps(z, inv));
+    float xyz[12];
+    for (int j = 0; j < 4; ++j) {
+      xyz[3 * j] = v[0][j];
+      xyz[3 * j + 1] = v[1][j];
+      xyz[3 * j + 2] = v[2][j];
     }
+    std::memcpy(out, xyz, sizeof(xyz));
+  };
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  auto decode4 = [&](uint8_t *out, const uint8_t *in) {
+    const int16x4x2_t e = vld2_s16(reinterpret_cast<const int16_t *>(in));
+    float32x4_t x = vmaxq_f32(
+        vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(e.val[0])), 1.0f / 32767.0f),
+        vdupq_n_f32(-1.0f));
+    float32x4_t y = vmaxq_f32(
+        vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(e.val[1])), 1.0f / 32767.0f),
+        vdupq_n_f32(-1.0f));
+    const float32x4_t z = vsubq_f32(vsubq_f32(one, vabsq_f32(x)), vabsq_f32(y));
+    const float32x4_t t = vmaxq_f32(vnegq_f32(z), zero);
+    x = vaddq_f32(x, vbslq_f32(vcgeq_f32(x, zero), vnegq_f32(t), t));
+    y = vaddq_f32(y, vbslq_f32(vcgeq_f32(y, zero), vnegq_f32(t), t));
+    const float32x4_t len2 = vaddq_f32(
+        vaddq_f32(vmulq_f32(x, x), vmulq_f32(y, y)), vmulq_f32(z, z));
+    const float32x4_t inv = vdivq_f32(one, vsqrtq_f32(len2));
+    float32x4x3_t v;
+    v.val[0] = vmulq_f32(x, inv);
+    v.val[1] = vmulq_f32(y, inv);
+    v.val[2] = vmulq_f32(z, inv);
+    vst3q_f32(reinterpret_cast<float *>(out), v);
+  };
+#endif
+#if defined(__SSE2__) || defined(_M_X64)                                      \
+    || (defined(__ARM_NEON) && defined(__aarch64__))
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    decode4(dst + i * 12, src + i * 4);
+  if (i < count) {
+    uint8_t in[16] = {};
+    uint8_t out[48];
+    std::memcpy(in, src + i * 4, (count - i) * 4);
+    decode4(out, in);
+    std::memcpy(dst + i * 12, out, (count - i) * 12);
   }
-  r->timeStepsStart = std::ftell(r->f);
-
-  // Initialize iteration positions
-  agxReaderResetConstants(r);
-  agxReaderResetTimeSteps(r);
-
-  return r;
+#else
+  for (size_t i = 0; i < count; ++i) {
+    int16_t e[2];
+    std::memcpy(e, src + i * 4, sizeof(e));
+    float x = std::max(e[0] * (1.0f / 32767.0f), -1.0f);
+    float y = std::max(e[1] * (1.0f / 32767.0f), -1.0f);
+    const float z = 1.0f - std::fabs(x) - std::fabs(y);
+    const float t = std::max(-z, 0.0f);
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+    const float inv = 1.0f / std::sqrt(x * x + y * y + z * z);
+    const float v[3] = {x * inv, y * inv, z * inv};
+    std::memcpy(dst + i * 12, v, sizeof(v));
+  }
+#endif
 }
 
-void agxReleaseReader(AGXReader r_)
+// 'n' uint16 components (cycling through 'components' 1..4) to floats:
+// lo[c] + q * scale[c]. Like octToNormals(), the vector paths handle the last
+// components through a padded copy.
+static void boundsToFloats(uint8_t *dst,
+    const uint8_t *src,
+    size_t n,
+    size_t components,
+    const float *lo,
+    const float *scale)
 {
-  if (!r_)
-    return;
-  if (r_->f)
-    std::fclose(r_->f);
-  delete r_;
+  // 12 lanes hold a whole number of elements of any component count
+  float base[12];
+  float step[12];
+  for (size_t j = 0; j < 12; ++j) {
+    base[j] = lo[j % components];
+    step[j] = scale[j % components];
+  }
+#if defined(__SSE2__) || defined(_M_X64)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 b0 = _mm_loadu_ps(base);
+  const __m128 b1 = _mm_loadu_ps(base + 4);
+  const __m128 b2 = _mm_loadu_ps(base + 8);
+  const __m128 s0 = _mm_loadu_ps(step);
+  const __m128 s1 = _mm_loadu_ps(step + 4);
+  const __m128 s2 = _mm_loadu_ps(step + 8);
+  auto decode12 = [&](uint8_t *out, const uint8_t *in) {
+    const __m128i q0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+    const __m128i q1 =
+        _mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + 16));
+    const __m128 f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(q0, zero));
+    const __m128 f1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(q0, zero));
+    const __m128 f2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(q1, zero));
+    float *f = reinterpret_cast<float *>(out);
+    _mm_storeu_ps(f, _mm_add_ps(b0, _mm_mul_ps(f0, s0)));
+    _mm_storeu_ps(f + 4, _mm_add_ps(b1, _mm_mul_ps(f1, s1)));
+    _mm_storeu_ps(f + 8, _mm_add_ps(b2, _mm_mul_ps(f2, s2)));
+  };
+#elif defined(__ARM_NEON)
+  const float32x4_t b0 = vld1q_f32(base);
+  const float32x4_t b1 = vld1q_f32(base + 4);
+  const float32x4_t b2 = vld1q_f32(base + 8);
+  const float32x4_t s0 = vld1q_f32(step);
+  const float32x4_t s1 = vld1q_f32(step + 4);
+  const float32x4_t s2 = vld1q_f32(step + 8);
+  auto decode12 = [&](uint8_t *out, const uint8_t *in) {
+    const uint16x8_t q0 = vreinterpretq_u16_u8(vld1q_u8(in));
+    const uint16x4_t q1 = vreinterpret_u16_u8(vld1_u8(in + 16));
+    const float32x4_t f0 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(q0)));
+    const float32x4_t f1 = vcvtq_f32_u32(vmovl_u16(vget_high_u16(q0)));
+    const float32x4_t f2 = vcvtq_f32_u32(vmovl_u16(q1));
+    vst1q_u8(out, vreinterpretq_u8_f32(vaddq_f32(b0, vmulq_f32(f0, s0))));
+    vst1q_u8(out + 16, vreinterpretq_u8_f32(vaddq_f32(b1, vmulq_f32(f1, s1))));
+    vst1q_u8(out + 32, vreinterpretq_u8_f32(vaddq_f32(b2, vmulq_f32(f2, s2))));
+  };
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || defined(__ARM_NEON)
+  size_t i = 0;
+  for (; i + 12 <= n; i += 12)
+    decode12(dst + i * 4, src + i * 2);
+  if (i < n) {
+    uint8_t in[24] = {};
+    uint8_t out[48];
+    std::memcpy(in, src + i * 2, (n - i) * 2);
+    decode12(out, in);
+    std::memcpy(dst + i * 4, out, (n - i) * 4);
+  }
+#else
+  for (size_t i = 0; i < n; ++i) {
+    uint16_t q;
+    std::memcpy(&q, src + i * 2, sizeof(q));
+    const float f = base[i % 12] + static_cast<float>(q) * step[i % 12];
+    std::memcpy(dst + i * 4, &f, sizeof(f));
+  }
+#endif
 }
 
-int agxReaderGetHeader(AGXReader r_, AGXHeader *out)
+// Element type a QUANTIZED record's array is stored as (ANARI_UNKNOWN for
+// invalid combinations). Relies on ANARI's enum layout, where the VEC2..VEC4
+// forms follow each scalar type.
+static ANARIDataType storedElementType(const AGXRecordInfo &info)
 {
-  if (!r_ || !out)
-    return 1;
-  *out = r_->hdr;
-  return 0;
+  const ANARIDataType type = static_cast<ANARIDataType>(info.type);
+  if (type < ANARI_FLOAT32 || type > ANARI_FLOAT32_VEC4)
+    return ANARI_UNKNOWN;
+  const int vec = type - ANARI_FLOAT32;
+  switch (info.quantization) {
+  case AGX_QUANTIZE_FLOAT16:
+    return static_cast<ANARIDataType>(ANARI_FLOAT16 + vec);
+  case AGX_QUANTIZE_OCT16:
+    return type == ANARI_FLOAT32_VEC3 ? ANARI_FIXED16_VEC2 : ANARI_UNKNOWN;
+  case AGX_QUANTIZE_BOUNDS16:
+    return static_cast<ANARIDataType>(ANARI_UFIXED16 + vec);
+  default:
+    return ANARI_UNKNOWN;
+  }
 }
 
-const char *agxReaderGetSubtype(AGXReader r)
+static bool isOpen(const AGXReader_t *r)
 {
-  return r->subtype.c_str();
+  return r->f || r->map || r->fd >= 0;
 }
 
-// Constants iteration
-void agxReaderResetConstants(AGXReader r_)
+// Resize a payload scratch buffer, counting reallocations
+static void resizeScratch(AGXReader_t *r, std::vector<uint8_t> &v, size_t n)
 {
-  if (!r_ || !r_->f)
-    return;
-  std::fseek(r_->f, r_->constantsStart, SEEK_SET);
-  r_->constantsRead = 0;
-  r_->lastName.clear();
-  r_->lastData.clear();
+  if (n > v.capacity())
+    r->stats.scratchReallocations++;
+  v.resize(n);
 }
 
-int agxReaderNextConstant(AGXReader r_, AGXParamView *out)
+#ifndef _WIN32
+static bool preadBytes(AGXReader_t *r, void *dst, size_t n)
 {
-  if (!r_ || !r_->f || !out)
-    return -1;
-  if (r_->constantsRead >= r_->hdr.constantParamCount)
-    return 0;
+  if (r->direct) {
+    if (!r->direct->read(r->fdPos, dst, n))
+      return false;
+    r->fdPos += n;
+    return true;
+  }
+  uint8_t *p = static_cast<uint8_t *>(dst);
+  while (n > 0) {
+    const ssize_t got = ::pread(r->fd, p, n, static_cast<off_t>(r->fdPos));
+    if (got < 0 && errno == EINTR)
+      continue;
+    if (got <= 0)
+      return false;
+    p += got;
+    n -= static_cast<size_t>(got);
+    r->fdPos += static_cast<uint64_t>(got);
+  }
+  return true;
+}
+#endif
+
+// Position the underlying file (not the mapping or a prefetched window)
+static bool seekFile(AGXReader_t *r, uint64_t pos)
+{
+  if (r->fd >= 0) {
+    r->fdPos = pos;
+    return true;
+  }
+  if (pos > static_cast<uint64_t>(LONG_MAX))
+    return false;
+  return std::fseek(r->f, static_cast<long>(pos), SEEK_SET) == 0;
+}
+
+// Stdio readers inside a prefetched window: return a pointer to the next 'n'
+// bytes and advance, or nullptr (leaving the window, to continue from the file)
+// if they aren't in it
+static const uint8_t *windowBytes(AGXReader_t *r, uint64_t n)
+{
+  const uint64_t end = r->windowStart + r->window.size();
+  if (n > end - r->windowPos) {
+    r->inWindow = false;
+    seekFile(r, r->windowPos);
+    return nullptr;
+  }
+  const uint8_t *p = r->window.data() + (r->windowPos - r->windowStart);
+  r->windowPos += n;
+  r->stats.bytesRead += n;
+  return p;
+}
+
+static bool readBytes(AGXReader_t *r, void *dst, size_t n)
+{
+  if (r->map) {
+    if (n > r->mapSize - r->mapPos)
+      return false;
+    std::memcpy(dst, r->map + r->mapPos, n);
+    r->mapPos += n;
+    r->stats.bytesRead += n;
+    return true;
+  }
+  if (r->inWindow) {
+    if (const uint8_t *p = windowBytes(r, n)) {
+      std::memcpy(dst, p, n);
+      return true;
+    }
+  }
+#ifndef _WIN32
+  const bool ok = r->fd >= 0 ? preadBytes(r, dst, n)
+                             : std::fread(dst, 1, n, r->f) == n;
+#else
+  const bool ok = std::fread(dst, 1, n, r->f) == n;
+#endif
+  if (ok)
+    r->stats.bytesRead += n;
+  return ok;
+}
+
+// Mapped readers only: return a pointer to the next 'n' bytes and advance
+static const uint8_t *viewBytes(AGXReader_t *r, uint64_t n)
+{
+  if (n > r->mapSize - r->mapPos)
+    return nullptr;
+  const uint8_t *p = r->map + r->mapPos;
+  r->mapPos += n;
+  r->stats.bytesRead += n;
+  return p;
+}
+
+static bool readU8(AGXReader_t *r, uint8_t &v)
+{
+  return readBytes(r, &v, 1);
+}
+
+static bool readU32(AGXReader_t *r, uint32_t &v, bool swap)
+{
+  if (!readBytes(r, &v, sizeof(v)))
+    return false;
+  if (swap)
+    v = bswap32(v);
+  return true;
+}
+
+static bool readU64(AGXReader_t *r, uint64_t &v, bool swap)
+{
+  if (!readBytes(r, &v, sizeof(v)))
+    return false;
+  if (swap)
+    v = bswap64(v);
+  return true;
+}
+
+static bool readF32(AGXReader_t *r, float &v, bool swap)
+{
+  uint32_t bits = 0;
+  if (!readU32(r, bits, swap))
+    return false;
+  std::memcpy(&v, &bits, sizeof(v));
+  return true;
+}
+
+static bool readF64(AGXReader_t *r, double &v, bool swap)
+{
+  uint64_t bits = 0;
+  if (!readU64(r, bits, swap))
+    return false;
+  std::memcpy(&v, &bits, sizeof(v));
+  return true;
+}
+
+// Read a time step header; files before v8 have no timestamps, their steps
+// are timed by index
+static bool readStepHeader(AGXReader_t *r,
+    uint32_t &index,
+    uint32_t &paramCount,
+    double *time = nullptr)
+{
+  if (!readU32(r, index, r->needSwap) || !readU32(r, paramCount, r->needSwap))
+    return false;
+  double t = static_cast<double>(index);
+  if (r->hdr.version >= 8 && !readF64(r, t, r->needSwap))
+    return false;
+  if (time)
+    *time = t;
+  return true;
+}
+
+static uint64_t tellPos(AGXReader_t *r)
+{
+  if (r->map)
+    return r->mapPos;
+  if (r->inWindow)
+    return r->windowPos;
+  if (r->fd >= 0)
+    return r->fdPos;
+  return static_cast<uint64_t>(std::ftell(r->f));
+}
+
+static bool seekPos(AGXReader_t *r, uint64_t pos)
+{
+  if (r->map) {
+    if (pos > r->mapSize)
+      return false;
+    r->mapPos = pos;
+    return true;
+  }
+  r->inWindow = !r->window.empty() && pos >= r->windowStart
+      && pos - r->windowStart < r->window.size();
+  if (r->inWindow) {
+    r->windowPos = pos;
+    return true;
+  }
+  return seekFile(r, pos);
+}
+
+static uint64_t fileSize(AGXReader_t *r)
+{
+  if (r->map)
+    return r->mapSize;
+#ifndef _WIN32
+  if (r->fd >= 0) {
+    struct stat st;
+    return ::fstat(r->fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+  }
+#endif
+  const long cur = std::ftell(r->f);
+  if (cur < 0 || std::fseek(r->f, 0, SEEK_END) != 0)
+    return 0;
+  const long end = std::ftell(r->f);
+  std::fseek(r->f, cur, SEEK_SET);
+  return end < 0 ? 0 : static_cast<uint64_t>(end);
+}
+
+static bool skipBytes(AGXReader_t *r, uint64_t n)
+{
+  if (r->map) {
+    if (n > r->mapSize - r->mapPos)
+      return false;
+    r->mapPos += n;
+    return true;
+  }
+  if (r->inWindow)
+    return seekPos(r, r->windowPos + n);
+  if (r->fd >= 0) {
+    r->fdPos += n;
+    return true;
+  }
+
+  // Attempt to fseek; if that fails (very large), fall back to buffered skip.
+  std::FILE *f = r->f;
+  if (n <= static_cast<uint64_t>(LONG_MAX)) {
+    if (std::fseek(f, static_cast<long>(n), SEEK_CUR) == 0)
+      return true;
+  }
+  const size_t bufSize = 64 * 1024;
+  std::vector<uint8_t> buf(bufSize);
+  uint64_t remaining = n;
+  while (remaining > 0) {
+    size_t chunk =
+        static_cast<size_t>(remaining > bufSize ? bufSize : remaining);
+    size_t readCount = std::fread(buf.data(), 1, chunk, f);
+    if (readCount != chunk)
+      return false;
+    remaining -= readCount;
+  }
+  return true;
+}
+
+// Produce a pointer to the next 'n' payload bytes: mapped readers return a
+// pointer into the mapping, others into a prefetched window or else read into
+// the reader's scratch buffer.
+static bool readPayload(AGXReader_t *r, uint64_t n, const void **out)
+{
+  if (r->map) {
+    const uint8_t *p = viewBytes(r, n);
+    if (!p)
+      return false;
+    *out = p;
+    return true;
+  }
+  if (r->inWindow) {
+    if (const uint8_t *p = windowBytes(r, n)) {
+      *out = p;
+      return true;
+    }
+  }
+  resizeScratch(r, r->lastData, static_cast<size_t>(n));
+  if (n > 0 && !readBytes(r, r->lastData.data(), static_cast<size_t>(n)))
+    return false;
+  *out = r->lastData.data();
+  return true;
+}
+
+static bool mapFile(AGXReader_t *r, const char *filename)
+{
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename,
+      GENERIC_READ,
+      FILE_SHARE_READ,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL,
+      nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    CloseHandle(file);
+    return false;
+  }
+  void *p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!p) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  r->mapFile = file;
+  r->mapHandle = mapping;
+  r->map = static_cast<const uint8_t *>(p);
+  r->mapSize = static_cast<uint64_t>(size.QuadPart);
+#else
+  int fd = ::open(filename, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st{};
+  if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+  void *p = ::mmap(
+      nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // the mapping keeps its own reference to the file
+  if (p == MAP_FAILED)
+    return false;
+  r->map = static_cast<const uint8_t *>(p);
+  r->mapSize = static_cast<uint64_t>(st.st_size);
+#endif
+  r->mapPos = 0;
+  return true;
+}
+
+static void unmapFile(AGXReader_t *r)
+{
+  if (!r->map)
+    return;
+  if (r->parent) {
+    r->map = nullptr; // the parent's mapping
+    r->mapSize = 0;
+    return;
+  }
+#ifdef _WIN32
+  UnmapViewOfFile(r->map);
+  CloseHandle(r->mapHandle);
+  CloseHandle(r->mapFile);
+#else
+  ::munmap(const_cast<uint8_t *>(r->map), static_cast<size_t>(r->mapSize));
+#endif
+  r->map = nullptr;
+  r->mapSize = 0;
+}
+
+// Decompress an encoded array payload
+static bool decompressPayload(uint8_t codec,
+    const void *src,
+    uint64_t srcBytes,
+    void *dst,
+    uint64_t dstBytes)
+{
+  switch (codec) {
+  case AGX_CODEC_NONE:
+    if (srcBytes != dstBytes)
+      return false;
+    if (dstBytes > 0)
+      std::memcpy(dst, src, static_cast<size_t>(dstBytes));
+    return true;
+#ifdef AGX_WITH_LZ4
+  case AGX_CODEC_LZ4: {
+    if (srcBytes > static_cast<uint64_t>(INT_MAX)
+        || dstBytes > static_cast<uint64_t>(INT_MAX))
+      return false;
+    const int n = LZ4_decompress_safe(static_cast<const char *>(src),
+        static_cast<char *>(dst),
+        static_cast<int>(srcBytes),
+        static_cast<int>(dstBytes));
+    return n >= 0 && static_cast<uint64_t>(n) == dstBytes;
+  }
+#endif
+#ifdef AGX_WITH_ZSTD
+  case AGX_CODEC_ZSTD: {
+    const size_t n = ZSTD_decompress(dst,
+        static_cast<size_t>(dstBytes),
+        src,
+        static_cast<size_t>(srcBytes));
+    return !ZSTD_isError(n) && n == dstBytes;
+  }
+#endif
+  default:
+    return false; // unknown codec, or not compiled in
+  }
+}
+
+// decompressPayload(), timed as decoding work of 'r'
+static bool decodeBytes(AGXReader_t *r,
+    uint8_t codec,
+    const void *src,
+    uint64_t srcBytes,
+    void *dst,
+    uint64_t dstBytes)
+{
+  AGXPhaseTimer t(&r->trace, "agx.read.decode", &r->stats.decodeSeconds);
+  return decompressPayload(codec, src, srcBytes, dst, dstBytes);
+}
+
+// Read a record's name (into r->lastName if 'keepName', else skipped) and
+// header fields, leaving the file positioned at the payload
+static bool readRecordHeader(AGXReader_t *r, AGXRecordInfo &info, bool keepName)
+{
+  r->stats.recordsParsed++;
+  if (!readU32(r, info.nameLen, r->needSwap))
+    return false;
+
+  if (keepName) {
+    r->lastName.resize(info.nameLen);
+    if (info.nameLen > 0 && !readBytes(r, r->lastName.data(), info.nameLen))
+      return false;
+  } else if (!skipBytes(r, info.nameLen))
+    return false;
+
+  if (!readU8(r, info.flags) || (info.flags & ~AGX_RECORD_KNOWN_FLAGS) != 0)
+    return false;
+
+  if (!(info.flags & AGX_RECORD_FLAG_ARRAY)) {
+    uint32_t valueBytes = 0;
+    if (info.flags != 0)
+      return false; // only arrays are encoded, delta-coded or referenced
+    if (!readU32(r, info.type, r->needSwap))
+      return false;
+    if (!readU32(r, valueBytes, r->needSwap))
+      return false;
+    info.dataBytes = info.storedBytes = valueBytes;
+    return true;
+  }
+
+  if (!readU32(r, info.type, r->needSwap))
+    return false;
+  if (!readU64(r, info.elementCount, r->needSwap))
+    return false;
+  if (!readU64(r, info.dataBytes, r->needSwap))
+    return false;
+  info.storedBytes = info.dataBytes;
+  if (info.flags & AGX_RECORD_FLAG_ENCODED) {
+    if (!readU8(r, info.codec))
+      return false;
+    if (!readU64(r, info.storedBytes, r->needSwap))
+      return false;
+  }
+  if (info.flags & AGX_RECORD_FLAG_DELTA) {
+    if (!readU8(r, info.deltaMode) || !readU8(r, info.laneBytes))
+      return false;
+    if (!readU64(r, info.baseOffset, r->needSwap))
+      return false;
+    if (info.deltaMode == AGX_DELTA_COPY
+        && !(info.flags & AGX_RECORD_FLAG_ENCODED))
+      info.storedBytes = 0;
+  }
+  if (info.flags & AGX_RECORD_FLAG_REF) {
+    if (info.flags & (AGX_RECORD_FLAG_ENCODED | AGX_RECORD_FLAG_DELTA))
+      return false;
+    if (!readU64(r, info.refOffset, r->needSwap))
+      return false;
+    info.storedBytes = 0;
+  }
+  if (info.flags & AGX_RECORD_FLAG_CHUNKED) {
+    const uint8_t other =
+        AGX_RECORD_FLAG_ENCODED | AGX_RECORD_FLAG_DELTA | AGX_RECORD_FLAG_REF;
+    if (info.flags & other)
+      return false;
+    if (!readU8(r, info.codec) || !readU64(r, info.chunkElements, r->needSwap)
+        || !readU64(r, info.storedBytes, r->needSwap))
+      return false;
+    if (info.elementCount == 0 || info.chunkElements == 0
+        || info.dataBytes % info.elementCount != 0)
+      return false;
+    info.chunkCount = (info.elementCount - 1) / info.chunkElements + 1;
+    if (info.chunkCount > UINT64_MAX / sizeof(uint64_t))
+      return false;
+    info.chunkIndexOffset = tellPos(r);
+    if (!skipBytes(r, info.chunkCount * sizeof(uint64_t)))
+      return false;
+  }
+  if (info.flags & AGX_RECORD_FLAG_QUANTIZED) {
+    const ANARIDataType type = static_cast<ANARIDataType>(info.type);
+    const size_t components = anari::componentsOf(type);
+    uint8_t boundsCount = 0;
+    if (!readU8(r, info.quantization) || !readU8(r, boundsCount))
+      return false;
+    const size_t storedBytes = anari::sizeOf(storedElementType(info));
+    const size_t expectedBounds =
+        info.quantization == AGX_QUANTIZE_BOUNDS16 ? components : 0;
+    if (storedBytes == 0 || info.elementCount == 0
+        || info.elementCount > UINT64_MAX / anari::sizeOf(type)
+        || info.dataBytes / storedBytes != info.elementCount
+        || info.dataBytes % storedBytes != 0 || boundsCount != expectedBounds)
+      return false;
+    for (size_t c = 0; c < boundsCount; ++c) {
+      if (!readF32(r, info.boundsMin[c], r->needSwap))
+        return false;
+    }
+    for (size_t c = 0; c < boundsCount; ++c) {
+      if (!readF32(r, info.boundsMax[c], r->needSwap))
+        return false;
+    }
+  }
+  info.dimensions = 1;
+  info.numItems[0] = info.elementCount;
+  info.numItems[1] = info.numItems[2] = 1;
+  if (info.flags & AGX_RECORD_FLAG_SHAPED) {
+    if (!readU8(r, info.dimensions) || info.dimensions < 2
+        || info.dimensions > 3)
+      return false;
+    uint64_t count = 1;
+    for (uint8_t d = 0; d < info.dimensions; ++d) {
+      uint64_t &n = info.numItems[d];
+      if (!readU64(r, n, r->needSwap) || (n != 0 && count > UINT64_MAX / n))
+        return false;
+      count *= n;
+    }
+    if (count != info.elementCount)
+      return false;
+  }
+  if (info.flags & AGX_RECORD_FLAG_ALIGNED) {
+    uint32_t padBytes = 0;
+    if (!readU32(r, padBytes, r->needSwap) || !skipBytes(r, padBytes))
+      return false;
+  }
+  return true;
+}
+
+// Read the name of the record at 'recordOffset', keeping the file position
+static bool readRecordName(
+    AGXReader_t *r, uint64_t recordOffset, std::string &name)
+{
+  const uint64_t pos = tellPos(r);
+  uint32_t nameLen = 0;
+  bool ok = seekPos(r, recordOffset) && readU32(r, nameLen, r->needSwap);
+  if (ok) {
+    name.resize(nameLen);
+    ok = nameLen == 0 || readBytes(r, &name[0], nameLen);
+  }
+  return seekPos(r, pos) && ok;
+}
+
+// Whether a record's payload is its data as is
+static bool isStoredRaw(const AGXRecordInfo &info)
+{
+  const uint8_t coded =
+      AGX_RECORD_FLAG_ENCODED | AGX_RECORD_FLAG_DELTA | AGX_RECORD_FLAG_REF;
+  if (info.flags & coded)
+    return false;
+  // Chunked arrays without a compressed chunk are laid out contiguously
+  return !(info.flags & AGX_RECORD_FLAG_CHUNKED)
+      || info.storedBytes == info.dataBytes;
+}
+
+// Load the chunk index of a CHUNKED record into r->chunkOffsets as payload
+// offsets (chunkCount + 1 entries), keeping the current file position
+static bool readChunkIndex(AGXReader_t *r, const AGXRecordInfo &info)
+{
+  const uint64_t pos = tellPos(r);
+  r->chunkOffsets.resize(static_cast<size_t>(info.chunkCount) + 1);
+  r->chunkOffsets[0] = 0;
+  bool ok = seekPos(r, info.chunkIndexOffset);
+  for (size_t c = 0; ok && c < info.chunkCount; ++c) {
+    uint64_t n = 0;
+    ok = readU64(r, n, r->needSwap) && n <= info.storedBytes;
+    r->chunkOffsets[c + 1] = r->chunkOffsets[c] + n;
+  }
+  ok = ok && r->chunkOffsets.back() == info.storedBytes;
+  return seekPos(r, pos) && ok;
+}
+
+// readChunkRange() with the chunk index already loaded. The last chunk needed
+// only in part stays decoded in r->chunkScratch for the next call.
+static bool copyChunkRange(AGXReader_t *r,
+    const AGXRecordInfo &info,
+    uint64_t payloadOffset,
+    uint64_t first,
+    uint64_t count,
+    uint8_t *dst)
+{
+  const uint64_t elementBytes = info.dataBytes / info.elementCount;
+  const uint64_t end = first + count;
+  for (uint64_t c = first / info.chunkElements;
+       c < info.chunkCount && c * info.chunkElements < end;
+       ++c) {
+    const uint64_t chunkFirst = c * info.chunkElements;
+    const uint64_t chunkEnd =
+        std::min(chunkFirst + info.chunkElements, info.elementCount);
+    const uint64_t rawBytes = (chunkEnd - chunkFirst) * elementBytes;
+    const uint64_t stored = r->chunkOffsets[c + 1] - r->chunkOffsets[c];
+    const uint64_t from = std::max(first, chunkFirst);
+    const uint64_t skip = (from - chunkFirst) * elementBytes;
+    const size_t n =
+        static_cast<size_t>((std::min(end, chunkEnd) - from) * elementBytes);
+    uint8_t *out = dst + (from - first) * elementBytes;
+
+    if (stored > rawBytes)
+      return false;
+    if (stored < rawBytes && n < rawBytes
+        && r->chunkScratchPayload == payloadOffset
+        && r->chunkScratchIndex == c) {
+      std::memcpy(out, r->chunkScratch.data() + skip, n);
+      continue;
+    }
+    if (!seekPos(r, payloadOffset + r->chunkOffsets[c]))
+      return false;
+    if (stored == rawBytes) {
+      if (!skipBytes(r, skip) || !readBytes(r, out, n))
+        return false;
+      continue;
+    }
+
+    const void *src = nullptr;
+    if (r->map) {
+      src = viewBytes(r, stored);
+      if (!src)
+        return false;
+    } else {
+      resizeScratch(r, r->lastEncoded, static_cast<size_t>(stored));
+      if (!readBytes(r, r->lastEncoded.data(), static_cast<size_t>(stored)))
+        return false;
+      src = r->lastEncoded.data();
+    }
+    if (n == rawBytes) {
+      if (!decodeBytes(r, info.codec, src, stored, out, rawBytes))
+        return false;
+      continue;
+    }
+    r->chunkScratchPayload = UINT64_MAX;
+    resizeScratch(r, r->chunkScratch, static_cast<size_t>(rawBytes));
+    if (!decodeBytes(
+            r, info.codec, src, stored, r->chunkScratch.data(), rawBytes))
+      return false;
+    r->chunkScratchPayload = payloadOffset;
+    r->chunkScratchIndex = c;
+    std::memcpy(out, r->chunkScratch.data() + skip, n);
+  }
+  return true;
+}
+
+// Decode elements [first, first + count) of the CHUNKED record whose payload
+// starts at 'payloadOffset' into 'dst', reading only the chunks they lie in
+static bool readChunkRange(AGXReader_t *r,
+    const AGXRecordInfo &info,
+    uint64_t payloadOffset,
+    uint64_t first,
+    uint64_t count,
+    uint8_t *dst)
+{
+  if (count == 0)
+    return true;
+  return readChunkIndex(r, info)
+      && copyChunkRange(r, info, payloadOffset, first, count, dst);
+}
+
+// Read an array payload, decompressing it if needed, into 'dst'
+// (info.dataBytes bytes)
+static bool decodePayloadTo(
+    AGXReader_t *r, const AGXRecordInfo &info, uint8_t *dst)
+{
+  if (!isStoredRaw(info) && (info.flags & AGX_RECORD_FLAG_CHUNKED)) {
+    const uint64_t payloadOffset = tellPos(r);
+    return readChunkRange(r, info, payloadOffset, 0, info.elementCount, dst)
+        && seekPos(r, payloadOffset + info.storedBytes);
+  }
+  if (!(info.flags & AGX_RECORD_FLAG_ENCODED))
+    return info.dataBytes == 0
+        || readBytes(r, dst, static_cast<size_t>(info.dataBytes));
+
+  const void *stored = nullptr;
+  if (r->map) {
+    stored = viewBytes(r, info.storedBytes);
+    if (!stored)
+      return false;
+  } else {
+    resizeScratch(r, r->lastEncoded, static_cast<size_t>(info.storedBytes));
+    if (!readBytes(
+            r, r->lastEncoded.data(), static_cast<size_t>(info.storedBytes)))
+      return false;
+    stored = r->lastEncoded.data();
+  }
+  return decodeBytes(
+      r, info.codec, stored, info.storedBytes, dst, info.dataBytes);
+}
+
+static bool readDecodedPayload(
+    AGXReader_t *r, const AGXRecordInfo &info, std::vector<uint8_t> &dst)
+{
+  resizeScratch(r, dst, static_cast<size_t>(info.dataBytes));
+  return decodePayloadTo(r, info, dst.data());
+}
+
+// Wrapping per-lane addition; lanes are in file byte order, so they are
+// swapped around the addition for cross-endian files
+template <typename T>
+static void addLanes(uint8_t *dst, const uint8_t *delta, size_t n, bool swap)
+{
+  for (size_t i = 0; i + sizeof(T) <= n; i += sizeof(T)) {
+    T x, d;
+    std::memcpy(&x, dst + i, sizeof(T));
+    std::memcpy(&d, delta + i, sizeof(T));
+    x = swap ? bswapValue(static_cast<T>(bswapValue(x) + bswapValue(d)))
+             : static_cast<T>(x + d);
+    std::memcpy(dst + i, &x, sizeof(T));
+  }
+}
+
+// Combine a decoded delta payload with its base array (in place)
+static bool applyDelta(const AGXRecordInfo &info,
+    uint8_t *data,
+    const uint8_t *delta,
+    size_t n,
+    bool swap)
+{
+  if (info.deltaMode == AGX_DELTA_XOR) {
+    for (size_t i = 0; i < n; ++i)
+      data[i] ^= delta[i];
+    return true;
+  }
+  if (info.deltaMode != AGX_DELTA_ADD)
+    return false;
+  switch (info.laneBytes) {
+  case 1:
+    addLanes<uint8_t>(data, delta, n, swap);
+    return true;
+  case 2:
+    addLanes<uint16_t>(data, delta, n, swap);
+    return true;
+  case 4:
+    addLanes<uint32_t>(data, delta, n, swap);
+    return true;
+  case 8:
+    addLanes<uint64_t>(data, delta, n, swap);
+    return true;
+  default:
+    return false;
+  }
+}
+
+static bool loadDecodedArray(
+    AGXReader_t *r, AGXDecodedArray &a, uint64_t recordOffset);
+
+// Decode the payload of the record at 'recordOffset' (positioned right after
+// its header) into 'a', resolving delta chains through earlier records
+static bool decodeArrayPayload(AGXReader_t *r,
+    const AGXRecordInfo &info,
+    AGXDecodedArray &a,
+    uint64_t recordOffset)
+{
+  if (info.flags & AGX_RECORD_FLAG_REF) {
+    if (info.refOffset >= recordOffset)
+      return false; // references always point back
+    if (!loadDecodedArray(r, a, info.refOffset)
+        || a.bytes.size() != info.dataBytes)
+      return false;
+  } else if (!(info.flags & AGX_RECORD_FLAG_DELTA)) {
+    a.valid = false;
+    if (!readDecodedPayload(r, info, a.bytes))
+      return false;
+  } else {
+    if (info.baseOffset >= recordOffset)
+      return false; // bases always precede their deltas
+    if (!loadDecodedArray(r, a, info.baseOffset)
+        || a.bytes.size() != info.dataBytes)
+      return false;
+    a.valid = false;
+    if (info.deltaMode != AGX_DELTA_COPY) {
+      if (!readDecodedPayload(r, info, r->deltaScratch))
+        return false;
+      AGXPhaseTimer t(&r->trace, "agx.read.decode", &r->stats.decodeSeconds);
+      if (!applyDelta(info,
+              a.bytes.data(),
+              r->deltaScratch.data(),
+              a.bytes.size(),
+              r->needSwap))
+        return false;
+    }
+  }
+  a.valid = true;
+  a.recordOffset = recordOffset;
+  return true;
+}
+
+// Make 'a' hold the decoded array of the record at 'recordOffset', keeping the
+// current file position
+static bool loadDecodedArray(
+    AGXReader_t *r, AGXDecodedArray &a, uint64_t recordOffset)
+{
+  if (a.valid && a.recordOffset == recordOffset)
+    return true;
+
+  const uint64_t pos = tellPos(r);
+  AGXRecordInfo info;
+  bool ok = seekPos(r, recordOffset) && readRecordHeader(r, info, false)
+      && (info.flags & AGX_RECORD_FLAG_ARRAY)
+      && decodeArrayPayload(r, info, a, recordOffset);
+  if (!ok)
+    a.valid = false;
+  return seekPos(r, pos) && ok;
+}
+
+// Resolve the target of a deduplicated array record, keeping the current file
+// position: raw targets of mapped readers are viewed in place, all others are
+// decoded once into r->refCache
+static bool resolveRef(AGXReader_t *r,
+    const AGXRecordInfo &info,
+    uint64_t recordOffset,
+    const void **data)
+{
+  if (info.refOffset >= recordOffset)
+    return false; // references always point back
+
+  auto it = r->refCache.find(info.refOffset);
+  if (it != r->refCache.end()) {
+    *data = it->second.data();
+    return it->second.size() == info.dataBytes;
+  }
+
+  const uint64_t pos = tellPos(r);
+  AGXRecordInfo target;
+  bool ok = seekPos(r, info.refOffset) && readRecordHeader(r, target, false)
+      && (target.flags & AGX_RECORD_FLAG_ARRAY)
+      && target.dataBytes == info.dataBytes;
+  if (ok && r->map && isStoredRaw(target)) {
+    *data = viewBytes(r, target.dataBytes);
+    ok = *data != nullptr;
+  } else if (ok) {
+    AGXDecodedArray a;
+    ok = decodeArrayPayload(r, target, a, info.refOffset);
+    if (ok) {
+      std::vector<uint8_t> &bytes = r->refCache[info.refOffset];
+      bytes = std::move(a.bytes);
+      *data = bytes.data();
+    }
+  }
+  return seekPos(r, pos) && ok;
+}
+
+// Whether the quantized array of 'info' is restored as it is read
+static bool dequantizes(const AGXReader_t *r, const AGXRecordInfo &info)
+{
+  return info.quantization != AGX_QUANTIZE_NONE && r->dequantize;
+}
+
+// Type of the value or array elements produced for the record of 'info'
+static ANARIDataType producedType(
+    const AGXReader_t *r, const AGXRecordInfo &info)
+{
+  if (info.quantization != AGX_QUANTIZE_NONE && !r->dequantize)
+    return storedElementType(info);
+  return static_cast<ANARIDataType>(info.type);
+}
+
+// Size of the data produced for the record of 'info'
+static uint64_t producedBytes(const AGXReader_t *r, const AGXRecordInfo &info)
+{
+  if (!dequantizes(r, info))
+    return info.dataBytes;
+  return info.elementCount
+      * anari::sizeOf(static_cast<ANARIDataType>(info.type));
+}
+
+// Fill 'out' with the metadata of the record just read by readRecordHeader()
+// (data = nullptr)
+static void describeRecord(const AGXReader_t *r,
+    const AGXRecordInfo &info,
+    uint64_t recordOffset,
+    AGXParamView *out)
+{
+  const bool isArray = (info.flags & AGX_RECORD_FLAG_ARRAY) != 0;
+  out->name = r->lastName.c_str();
+  out->nameLength = info.nameLen;
+  out->isArray = isArray ? 1 : 0;
+  out->type = isArray ? (ANARIDataType)0 : static_cast<ANARIDataType>(info.type);
+  out->elementType = isArray ? producedType(r, info) : (ANARIDataType)0;
+  out->elementCount = isArray ? info.elementCount : 0;
+  out->dimensions = isArray ? info.dimensions : 0;
+  for (int d = 0; d < 3; ++d)
+    out->numItems[d] = isArray ? info.numItems[d] : 0;
+  out->data = nullptr;
+  out->dataBytes = producedBytes(r, info);
+  out->recordOffset = recordOffset;
+  out->part = 0;
+  out->quantization =
+      dequantizes(r, info) ? uint8_t(AGX_QUANTIZE_NONE) : info.quantization;
+  for (int c = 0; c < 4; ++c) {
+    out->boundsMin[c] = out->quantization ? info.boundsMin[c] : 0.0f;
+    out->boundsMax[c] = out->quantization ? info.boundsMax[c] : 0.0f;
+  }
+}
+
+// Produce a pointer to the decoded payload of the record at 'recordOffset',
+// whose header was just read
+static bool readRecordPayload(AGXReader_t *r,
+    const AGXRecordInfo &info,
+    uint64_t recordOffset,
+    const void **data)
+{
+  r->lastData.clear();
+
+  if (info.flags & AGX_RECORD_FLAG_REF)
+    return resolveRef(r, info, recordOffset, data);
+  if (info.flags & AGX_RECORD_FLAG_DELTA) {
+    // Delta-encoded arrays are reconstructed in the per-name cache
+    AGXDecodedArray &a = r->deltaCache[r->lastName];
+    if (!decodeArrayPayload(r, info, a, recordOffset))
+      return false;
+    *data = a.bytes.data();
+    return true;
+  }
+  if (!isStoredRaw(info)) {
+    // Compressed payloads are always decoded into the scratch buffer
+    if (!readDecodedPayload(r, info, r->lastData))
+      return false;
+    *data = r->lastData.data();
+    return true;
+  }
+  return readPayload(r, info.dataBytes, data);
+}
+
+// Like readRecordPayload(), but into 'dst' (info.dataBytes bytes): raw and
+// compressed payloads go there directly, only arrays which later records may
+// build on are decoded into the reader's caches first
+static bool readRecordPayloadInto(AGXReader_t *r,
+    const AGXRecordInfo &info,
+    uint64_t recordOffset,
+    void *dst)
+{
+  if (info.flags & (AGX_RECORD_FLAG_REF | AGX_RECORD_FLAG_DELTA)) {
+    const void *data = nullptr;
+    if (!readRecordPayload(r, info, recordOffset, &data))
+      return false;
+    if (info.dataBytes > 0)
+      std::memcpy(dst, data, static_cast<size_t>(info.dataBytes));
+    return true;
+  }
+  if (!isStoredRaw(info))
+    return decodePayloadTo(r, info, static_cast<uint8_t *>(dst));
+  return info.dataBytes == 0
+      || readBytes(r, dst, static_cast<size_t>(info.dataBytes));
+}
+
+// Whether payloads of 'r' are converted to host byte order as they are read
+static bool convertsByteOrder(const AGXReader_t *r)
+{
+  return r->convertByteOrder && r->needSwap;
+}
+
+// Convert a decoded payload to host byte order: in place if it is the
+// reader's scratch copy, otherwise (mapping, window, caches -- which must stay
+// in file order) into swapScratch
+static const void *toHostOrder(
+    AGXReader_t *r, const AGXRecordInfo &info, const void *data)
+{
+  const size_t lane = swapLaneBytes(producedType(r, info));
+  const size_t n = static_cast<size_t>(info.dataBytes);
+  if (lane == 0 || n == 0)
+    return data;
+  AGXPhaseTimer t(&r->trace, "agx.read.decode", &r->stats.decodeSeconds);
+  if (data == r->lastData.data()) {
+    swapLanes(r->lastData.data(), r->lastData.data(), n, lane);
+    return data;
+  }
+  resizeScratch(r, r->swapScratch, n);
+  swapLanes(r->swapScratch.data(), static_cast<const uint8_t *>(data), n, lane);
+  return r->swapScratch.data();
+}
+
+// Restore 'count' elements of the quantized array of 'info' from 'src' (as
+// stored, in file byte order) into 'dst', in file byte order unless converted
+// (convertsByteOrder)
+static void dequantizeArray(AGXReader_t *r,
+    const AGXRecordInfo &info,
+    const uint8_t *src,
+    uint64_t count,
+    uint8_t *dst)
+{
+  AGXPhaseTimer t(&r->trace, "agx.read.decode", &r->stats.decodeSeconds);
+  const size_t components =
+      anari::componentsOf(static_cast<ANARIDataType>(info.type));
+  const size_t n = static_cast<size_t>(count) * components;
+  if (r->needSwap) {
+    const size_t storedBytes =
+        static_cast<size_t>(count * (info.dataBytes / info.elementCount));
+    resizeScratch(r, r->swapScratch, storedBytes);
+    swapLanes(r->swapScratch.data(), src, storedBytes, 2);
+    src = r->swapScratch.data();
+  }
+  switch (info.quantization) {
+  case AGX_QUANTIZE_FLOAT16:
+    halfToFloats(dst, src, n);
+    break;
+  case AGX_QUANTIZE_OCT16:
+    octToNormals(dst, src, static_cast<size_t>(count));
+    break;
+  case AGX_QUANTIZE_BOUNDS16: {
+    float scale[4];
+    for (size_t c = 0; c < components; ++c) {
+      scale[c] = static_cast<float>(
+          (double(info.boundsMax[c]) - double(info.boundsMin[c])) / 65535.0);
+    }
+    boundsToFloats(dst, src, n, components, info.boundsMin, scale);
+    break;
+  }
+  default:
+    break;
+  }
+  if (r->needSwap && !r->convertByteOrder)
+    swapLanes(dst, dst, n * sizeof(float), sizeof(float));
+}
+
+// Read a parameter record into reader's scratch storage and produce a view
+static bool readParamRecord(AGXReader_t *r, AGXParamView *out)
+{
+  const uint64_t recordOffset = tellPos(r);
+  AGXRecordInfo info;
+  if (!readRecordHeader(r, info, true))
+    return false;
+
+  AGXPhaseTimer t(&r->trace, "agx.read.payload", &r->stats.payloadSeconds);
+  const void *data = nullptr;
+  if (!readRecordPayload(r, info, recordOffset, &data))
+    return false;
+  if (dequantizes(r, info)) {
+    resizeScratch(
+        r, r->quantScratch, static_cast<size_t>(producedBytes(r, info)));
+    dequantizeArray(r,
+        info,
+        static_cast<const uint8_t *>(data),
+        info.elementCount,
+        r->quantScratch.data());
+    data = r->quantScratch.data();
+  } else if (convertsByteOrder(r)) {
+    data = toHostOrder(r, info, data);
+  }
+  describeRecord(r, info, recordOffset, out);
+  out->data = data;
+  return true;
+}
+
+// Skip over a parameter record (used to locate the start of time step section)
+static bool skipParamRecord(AGXReader_t *r)
+{
+  AGXRecordInfo info;
+  if (!readRecordHeader(r, info, false) || !skipBytes(r, info.storedBytes))
+    return false;
+  r->stats.recordsSkipped++;
+  r->stats.bytesSkipped += info.storedBytes;
+  return true;
+}
+
+static bool readTocEntries(AGXReader_t *r,
+    std::vector<AGXRecordLocation> &v,
+    uint32_t expectedCount,
+    uint64_t limit)
+{
+  uint32_t count = 0;
+  if (!readU32(r, count, r->needSwap) || count != expectedCount)
+    return false;
+  v.resize(count);
+  for (auto &e : v) {
+    if (!readU64(r, e.offset, r->needSwap) || !readU64(r, e.size, r->needSwap))
+      return false;
+    if (e.offset > limit || e.size > limit - e.offset)
+      return false;
+  }
+  return true;
+}
+
+// Load the table of contents via the footer at the end of the file. Returns
+// false (leaving the reader without a TOC) if it is missing or inconsistent,
+// e.g. for files whose writer never finished.
+static bool readToc(AGXReader_t *r)
+{
+  const uint64_t size = fileSize(r);
+  if (size < 12 || !seekPos(r, size - 12))
+    return false;
+
+  uint64_t tocOffset = 0;
+  char magic[4];
+  if (!readU64(r, tocOffset, r->needSwap) || !readBytes(r, magic, 4)
+      || std::memcmp(magic, "AGXF", 4) != 0)
+    return false;
+  const uint64_t tocLimit = size - 12;
+  if (tocOffset >= tocLimit || !seekPos(r, tocOffset))
+    return false;
+
+  uint64_t timeStepsStart = 0;
+  if (!readBytes(r, magic, 4) || std::memcmp(magic, "AGXT", 4) != 0
+      || !readU64(r, timeStepsStart, r->needSwap) || timeStepsStart > tocOffset)
+    return false;
+
+  std::vector<AGXRecordLocation> constants;
+  std::vector<AGXRecordLocation> steps;
+  if (!readTocEntries(r, constants, r->hdr.constantParamCount, tocOffset)
+      || !readTocEntries(r, steps, r->hdr.timeSteps, tocOffset))
+    return false;
+  std::vector<double> times(r->hdr.version >= 8 ? steps.size() : 0);
+  for (auto &t : times) {
+    if (!readF64(r, t, r->needSwap))
+      return false;
+  }
+
+  r->constantRecords = std::move(constants);
+  r->stepRecords = std::move(steps);
+  if (!times.empty())
+    r->stepTimes = std::move(times);
+  r->hasToc = true;
+  r->stepIndexBuilt = true;
+  r->timeStepsStart = timeStepsStart;
+  r->timeStepsStartKnown = true;
+  return true;
+}
+
+// Try to load the TOC once; moves the file position
+static void ensureToc(AGXReader_t *r)
+{
+  if (r->tocLoaded)
+    return;
+  r->tocLoaded = true;
+  AGXPhaseTimer t(&r->trace, "agx.read.locate", &r->stats.locateSeconds);
+  if (r->hdr.version >= 2)
+    readToc(r);
+}
+
+// Find the start of the time step section: taken from the TOC if present,
+// otherwise found by skipping over all constants. Moves the file position.
+static bool ensureTimeStepsStart(AGXReader_t *r)
+{
+  if (r->timeStepsStartKnown)
+    return true;
+  ensureToc(r);
+  if (r->timeStepsStartKnown)
+    return true;
+
+  AGXPhaseTimer t(&r->trace, "agx.read.locate", &r->stats.locateSeconds);
+  if (!seekPos(r, r->constantsStart))
+    return false;
+  for (uint32_t i = 0; i < r->hdr.constantParamCount; ++i) {
+    if (!skipParamRecord(r))
+      return false;
+  }
+  r->timeStepsStart = tellPos(r);
+  r->timeStepsStartKnown = true;
+  return true;
+}
+
+// Locate every time step by walking the time step section once (files
+// without a TOC).
+static bool buildStepIndex(AGXReader_t *r)
+{
+  if (r->stepIndexBuilt)
+    return true;
+  if (!ensureTimeStepsStart(r) || r->stepIndexBuilt)
+    return r->stepIndexBuilt;
+  AGXPhaseTimer t(&r->trace, "agx.read.locate", &r->stats.locateSeconds);
+  if (!seekPos(r, r->timeStepsStart))
+    return false;
+
+  std::vector<AGXRecordLocation> steps(r->hdr.timeSteps);
+  std::vector<double> times(r->hdr.timeSteps);
+  for (size_t s = 0; s < steps.size(); ++s) {
+    AGXRecordLocation &e = steps[s];
+    e.offset = tellPos(r);
+    uint32_t index = 0;
+    uint32_t paramCount = 0;
+    if (!readStepHeader(r, index, paramCount, &times[s]))
+      return false;
+    for (uint32_t i = 0; i < paramCount; ++i) {
+      if (!skipParamRecord(r))
+        return false;
+    }
+    e.size = tellPos(r) - e.offset;
+  }
+
+  r->stepRecords = std::move(steps);
+  r->stepTimes = std::move(times);
+  r->stepIndexBuilt = true;
+  return true;
+}
+
+// Resolve the timestamps of all time steps (v8+: from the TOC or the step
+// index scan; older files: the step indices). Moves the file position.
+static bool ensureStepTimes(AGXReader_t *r)
+{
+  if (r->stepTimes.size() == r->hdr.timeSteps)
+    return true;
+  if (r->hdr.version < 8) {
+    r->stepTimes.resize(r->hdr.timeSteps);
+    for (size_t i = 0; i < r->stepTimes.size(); ++i)
+      r->stepTimes[i] = static_cast<double>(i);
+    return true;
+  }
+  return buildStepIndex(r) && r->stepTimes.size() == r->hdr.timeSteps;
+}
+
+// Two-phase reading //////////////////////////////////////////////////////////
+
+// Drop a pending peek, returning to the start of the peeked record
+static bool cancelPeek(AGXReader_t *r)
+{
+  if (!r->peeked)
+    return true;
+  r->peeked = false;
+  return seekPos(r, r->peekOffset);
+}
+
+static int peekRecord(AGXReader_t *r, AGXParamView *out, bool constant)
+{
+  if (r->peeked && r->peekedConstant == constant) {
+    describeRecord(r, r->peekInfo, r->peekOffset, out);
+    return 1;
+  }
+  if (!cancelPeek(r))
+    return -1;
+
+  const uint64_t recordOffset = tellPos(r);
+  AGXRecordInfo info;
+  if (!readRecordHeader(r, info, true))
+    return -1;
+  r->peeked = true;
+  r->peekedConstant = constant;
+  r->peekOffset = recordOffset;
+  r->peekInfo = info;
+  describeRecord(r, info, recordOffset, out);
+  return 1;
+}
+
+// Lookup by name //////////////////////////////////////////////////////////////
+
+// Index the names of the 'count' records starting at 'offset'; moves the file
+// position
+static bool buildNameIndex(
+    AGXReader_t *r, AGXNameIndex &index, uint64_t offset, uint32_t count)
+{
+  if (index.built)
+    return true;
+  if (!seekPos(r, offset))
+    return false;
+
+  std::unordered_map<std::string, uint64_t> offsets;
+  offsets.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    const uint64_t recordOffset = tellPos(r);
+    AGXRecordInfo info;
+    if (!readRecordHeader(r, info, true) || !skipBytes(r, info.storedBytes))
+      return false;
+    offsets.emplace(r->lastName, recordOffset); // first one wins
+  }
+  index.offsets = std::move(offsets);
+  index.built = true;
+  return true;
+}
+
+// Read the record named 'name' from an indexed section, keeping the iteration
+// position
+static int findRecord(AGXReader_t *r,
+    const AGXNameIndex &index,
+    const char *name,
+    AGXParamView *out)
+{
+  auto it = index.offsets.find(name);
+  if (it == index.offsets.end())
+    return 0;
+  AGXParamView v{};
+  if (!seekPos(r, it->second) || !readParamRecord(r, &v))
+    return -1;
+  *out = v;
+  return 1;
+}
+
+// Prefetching ////////////////////////////////////////////////////////////////
+
+// Load one block: read into the slot (stdio readers) or fault in its pages
+static bool loadPrefetchSlot(
+    AGXPrefetcher &p, std::FILE *f, AGXPrefetchSlot &s)
+{
+  if (p.map) {
+    volatile uint8_t sink = 0;
+    for (uint64_t i = 0; i < s.size; i += 4096)
+      sink ^= p.map[s.offset + i];
+    (void)sink;
+    return true;
+  }
+  if (!f || s.offset > static_cast<uint64_t>(LONG_MAX)
+      || std::fseek(f, static_cast<long>(s.offset), SEEK_SET) != 0)
+    return false;
+  s.bytes.resize(static_cast<size_t>(s.size));
+  return std::fread(s.bytes.data(), 1, s.bytes.size(), f) == s.bytes.size();
+}
+
+static void prefetchWorker(AGXPrefetcher *p)
+{
+  std::FILE *f = p->map ? nullptr : std::fopen(p->filename.c_str(), "rb");
+
+  std::unique_lock<std::mutex> lock(p->mutex);
+  while (!p->stop) {
+    // Lowest queued time step first
+    AGXPrefetchSlot *next = nullptr;
+    for (auto &s : p->slots) {
+      if (s->state == AGXPrefetchSlot::QUEUED
+          && (!next || s->step < next->step))
+        next = s.get();
+    }
+    if (!next) {
+      p->changed.wait(lock);
+      continue;
+    }
+
+    next->state = AGXPrefetchSlot::LOADING;
+    lock.unlock();
+    const bool ok = loadPrefetchSlot(*p, f, *next);
+    lock.lock();
+    if (next->dropped) {
+      next->state = AGXPrefetchSlot::EMPTY;
+      next->dropped = false;
+    } else
+      next->state = ok ? AGXPrefetchSlot::READY : AGXPrefetchSlot::FAILED;
+    p->changed.notify_all();
+  }
+
+  if (f)
+    std::fclose(f);
+}
+
+static void stopPrefetcher(AGXReader_t *r)
+{
+  if (!r->prefetch)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(r->prefetch->mutex);
+    r->prefetch->stop = true;
+  }
+  r->prefetch->changed.notify_all();
+  if (r->prefetch->worker.joinable())
+    r->prefetch->worker.join();
+  r->prefetch.reset();
+}
+
+// Slot of the time step 'index' which isn't EMPTY, or nullptr; requires the
+// prefetcher's mutex
+static AGXPrefetchSlot *findPrefetchSlot(AGXPrefetcher &p, uint32_t index)
+{
+  for (auto &s : p.slots) {
+    if (s->state != AGXPrefetchSlot::EMPTY && !s->dropped && s->step == index)
+      return s.get();
+  }
+  return nullptr;
+}
+
+static int prefetchStatus(const AGXPrefetchSlot *s)
+{
+  if (!s || s->state == AGXPrefetchSlot::FAILED)
+    return -1;
+  return s->state == AGXPrefetchSlot::READY ? 1 : 0;
+}
+
+// Take over the prefetched block starting at the current position, if any,
+// waiting for it if it is being loaded. Called at the start of a time step.
+static void usePrefetchedStep(AGXReader_t *r)
+{
+  if (!r->prefetch)
+    return;
+  AGXPrefetcher &p = *r->prefetch;
+  const uint64_t pos = tellPos(r);
+
+  std::unique_lock<std::mutex> lock(p.mutex);
+  AGXPrefetchSlot *s = nullptr;
+  for (auto &c : p.slots) {
+    if (c->state != AGXPrefetchSlot::EMPTY && !c->dropped && c->offset == pos)
+      s = c.get();
+  }
+  if (!s)
+    return;
+  {
+    AGXPhaseTimer t(
+        &r->trace, "agx.read.prefetchWait", &r->stats.prefetchWaitSeconds);
+    p.changed.wait(
+        lock, [&]() { return s->state != AGXPrefetchSlot::LOADING; });
+  }
+
+  if (s->state == AGXPrefetchSlot::READY && !r->map) {
+    std::swap(r->window, s->bytes);
+    r->windowStart = pos;
+    seekPos(r, pos);
+  }
+  s->state = AGXPrefetchSlot::EMPTY; // queued ones are read directly instead
+  s->bytes.clear();
+}
+
+// Split files /////////////////////////////////////////////////////////////////
+
+static bool isAbsolutePath(const std::string &path)
+{
+#ifdef _WIN32
+  return (!path.empty() && (path[0] == '/' || path[0] == '\\'))
+      || (path.size() > 1 && path[1] == ':');
+#else
+  return !path.empty() && path[0] == '/';
+#endif
+}
+
+// Parse the rest of a split manifest, after its magic
+static bool primeSplit(AGXReader_t *r)
+{
+  uint32_t version = 0;
+  uint32_t endianMarker = 0;
+  uint32_t objectType = ANARI_UNKNOWN;
+  uint32_t timeSteps = 0;
+  uint32_t partCount = 0;
+  if (!readU32(r, version, false) || !readU32(r, endianMarker, false))
+    return false;
+  if (endianMarker == 0x01020304u)
+    r->needSwap = false;
+  else if (bswap32(endianMarker) == 0x01020304u)
+    r->needSwap = true;
+  else
+    return false;
+  r->fileLittle = r->needSwap ? !r->hostLittle : r->hostLittle;
+  if (r->needSwap)
+    version = bswap32(version);
+  if (version == 0 || version > AGX_READER_MAX_MANIFEST_VERSION
+      || !readU32(r, objectType, r->needSwap)
+      || !readU32(r, timeSteps, r->needSwap)
+      || !readU32(r, partCount, r->needSwap))
+    return false;
+
+  uint32_t subtypeLen = 0;
+  if (!readU32(r, subtypeLen, r->needSwap))
+    return false;
+  r->subtype.resize(subtypeLen);
+  if (subtypeLen > 0 && !readBytes(r, r->subtype.data(), subtypeLen))
+    return false;
+
+  // Bound the counts by the file size before allocating for them
+  const uint64_t size = fileSize(r);
+  const uint64_t pos = tellPos(r);
+  if (pos > size || timeSteps > (size - pos) / sizeof(double)
+      || partCount > (size - pos - timeSteps * sizeof(double)) / 12)
+    return false;
+  r->stepTimes.resize(timeSteps);
+  for (auto &t : r->stepTimes) {
+    if (!readF64(r, t, r->needSwap))
+      return false;
+  }
+
+  std::unique_ptr<AGXSplitFile> split(new (std::nothrow) AGXSplitFile);
+  if (!split)
+    return false;
+  split->mapped = r->map != nullptr;
+  split->backend = r->direct ? AGX_IO_DIRECT : AGX_IO_STDIO;
+  const size_t slash = r->filename.find_last_of("/\\");
+  const std::string dir =
+      slash == std::string::npos ? "" : r->filename.substr(0, slash + 1);
+  split->parts.resize(partCount);
+  for (auto &p : split->parts) {
+    uint32_t pathLen = 0;
+    if (!readU32(r, p.firstTimeStep, r->needSwap)
+        || !readU32(r, p.timeStepCount, r->needSwap)
+        || !readU32(r, pathLen, r->needSwap) || pathLen > size)
+      return false;
+    p.filename.resize(pathLen);
+    if (pathLen > 0 && !readBytes(r, p.filename.data(), pathLen))
+      return false;
+    if (p.filename.empty() || p.timeStepCount > timeSteps
+        || p.firstTimeStep > timeSteps - p.timeStepCount)
+      return false;
+    if (!isAbsolutePath(p.filename))
+      p.filename = dir + p.filename;
+  }
+
+  r->hdr.version = version;
+  r->hdr.objectType = static_cast<ANARIDataType>(objectType);
+  r->hdr.timeSteps = timeSteps;
+  r->hdr.constantParamCount = 0; // counted by agxReaderGetHeader()
+  r->hdr.partCount = partCount;
+  r->hdr.endianMarker = endianMarker;
+  r->hdr.hostLittleEndian = r->hostLittle ? 1 : 0;
+  r->hdr.fileLittleEndian = r->fileLittle ? 1 : 0;
+  r->hdr.needByteSwap = r->needSwap ? 1 : 0;
+  r->split = std::move(split);
+  return true;
+}
+
+// Reader of part 'index', opened with the manifest's backend and settings on
+// first use; nullptr on error
+static AGXReader_t *openPart(AGXReader_t *r, uint32_t index)
+{
+  AGXReaderPart &p = r->split->parts[index];
+  if (p.reader)
+    return p.reader;
+  const char *filename = p.filename.c_str();
+  AGXReader_t *part = r->split->mapped
+      ? agxNewReaderMapped(filename)
+      : agxNewReaderWithIO(filename, r->split->backend);
+  if (part && (part->split || part->hdr.timeSteps != p.timeStepCount)) {
+    agxReleaseReader(part); // nested manifest or a different part
+    part = nullptr;
+  }
+  if (!part)
+    return nullptr;
+  part->convertByteOrder = r->convertByteOrder;
+  part->dequantize = r->dequantize;
+  part->trace = r->trace;
+  p.reader = part;
+  return part;
+}
+
+static bool coversTimeStep(const AGXReaderPart &p, uint32_t timeStep)
+{
+  return timeStep >= p.firstTimeStep
+      && timeStep - p.firstTimeStep < p.timeStepCount;
+}
+
+// Reader holding the record of 'view' (by any call on 'r')
+static AGXReader_t *viewSource(AGXReader_t *r, const AGXParamView *view)
+{
+  if (!r->split)
+    return r;
+  if (!view || view->part >= r->split->parts.size())
+    return nullptr;
+  return r->split->parts[view->part].reader;
+}
+
+static int splitGetHeader(AGXReader_t *r, AGXHeader *out)
+{
+  AGXSplitFile &s = *r->split;
+  if (!s.constantsCounted) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < s.parts.size(); ++i) {
+      const AGXReader_t *part = openPart(r, i);
+      if (!part)
+        return 2;
+      count += part->hdr.constantParamCount;
+    }
+    r->hdr.constantParamCount = count;
+    s.constantsCounted = true;
+  }
+  *out = r->hdr;
+  return 0;
+}
+
+static void splitResetConstants(AGXReader_t *r)
+{
+  r->split->constantPart = 0;
+  r->split->constantPartReset = false;
+  r->split->peekPart = UINT32_MAX;
+}
+
+// agxReaderNextConstant() / agxReaderPeekConstant() over the parts in order
+static int splitConstant(AGXReader_t *r, AGXParamView *out, bool peek)
+{
+  AGXSplitFile &s = *r->split;
+  s.peekPart = UINT32_MAX;
+  while (s.constantPart < s.parts.size()) {
+    AGXReader_t *part = openPart(r, s.constantPart);
+    if (!part)
+      return -1;
+    if (!s.constantPartReset) {
+      agxReaderResetConstants(part);
+      s.constantPartReset = true;
+    }
+    const int rc = peek ? agxReaderPeekConstant(part, out)
+                        : agxReaderNextConstant(part, out);
+    if (rc != 0) {
+      if (rc == 1) {
+        out->part = s.constantPart;
+        s.peekPart = peek ? s.constantPart : UINT32_MAX;
+      }
+      return rc;
+    }
+    s.constantPart++;
+    s.constantPartReset = false;
+  }
+  return 0;
+}
+
+static void splitResetTimeSteps(AGXReader_t *r)
+{
+  r->stepsRead = 0;
+  r->inStep = false;
+  r->split->stepParts.clear();
+  r->split->peekPart = UINT32_MAX;
+}
+
+static int splitBeginNextTimeStep(
+    AGXReader_t *r, uint32_t *outIndex, uint32_t *outParamCount)
+{
+  AGXSplitFile &s = *r->split;
+  if (r->stepsRead >= r->hdr.timeSteps)
+    return 0;
+  const uint32_t step = r->stepsRead;
+  r->inStep = false;
+  s.stepParts.clear();
+  s.stepPart = 0;
+  s.peekPart = UINT32_MAX;
+
+  // Position every part covering the step at it
+  uint32_t paramCount = 0;
+  for (uint32_t i = 0; i < s.parts.size(); ++i) {
+    if (!coversTimeStep(s.parts[i], step))
+      continue;
+    AGXReader_t *part = openPart(r, i);
+    if (!part)
+      return -1;
+    uint32_t index = 0;
+    uint32_t count = 0;
+    if (agxReaderSeekTimeStep(part, step - s.parts[i].firstTimeStep) != 0
+        || agxReaderBeginNextTimeStep(part, &index, &count) != 1)
+      return -1;
+    paramCount += count;
+    s.stepParts.push_back(i);
+  }
+
+  r->inStep = true;
+  r->curStepIndex = step;
+  r->curStepParamCount = paramCount;
+  r->stepsRead++;
+  *outIndex = step;
+  *outParamCount = paramCount;
+  return 1;
+}
+
+// agxReaderNextTimeStepParam() / agxReaderPeekTimeStepParam() over the parts
+// covering the current time step
+static int splitTimeStepParam(AGXReader_t *r, AGXParamView *out, bool peek)
+{
+  AGXSplitFile &s = *r->split;
+  s.peekPart = UINT32_MAX;
+  while (r->inStep && s.stepPart < s.stepParts.size()) {
+    const uint32_t index = s.stepParts[s.stepPart];
+    AGXReader_t *part = s.parts[index].reader;
+    const int rc = peek ? agxReaderPeekTimeStepParam(part, out)
+                        : agxReaderNextTimeStepParam(part, out);
+    if (rc != 0) {
+      if (rc == 1) {
+        out->part = index;
+        s.peekPart = peek ? index : UINT32_MAX;
+      }
+      return rc;
+    }
+    s.stepPart++;
+  }
+  r->inStep = false;
+  return 0;
+}
+
+static void splitSkipRemainingTimeStep(AGXReader_t *r)
+{
+  AGXSplitFile &s = *r->split;
+  for (; r->inStep && s.stepPart < s.stepParts.size(); ++s.stepPart)
+    agxReaderSkipRemainingTimeStep(s.parts[s.stepParts[s.stepPart]].reader);
+  s.peekPart = UINT32_MAX;
+  r->inStep = false;
+}
+
+static int splitSeekTimeStep(AGXReader_t *r, uint32_t index)
+{
+  if (index >= r->hdr.timeSteps)
+    return 2;
+  splitResetTimeSteps(r);
+  r->stepsRead = index;
+  return 0;
+}
+
+static int splitFindConstant(
+    AGXReader_t *r, const char *name, AGXParamView *out)
+{
+  for (uint32_t i = 0; i < r->split->parts.size(); ++i) {
+    AGXReader_t *part = openPart(r, i);
+    const int rc = part ? agxReaderFindConstant(part, name, out) : -1;
+    if (rc != 0) {
+      if (rc == 1)
+        out->part = i;
+      return rc;
+    }
+  }
+  return 0;
+}
+
+static int splitFindTimeStepParam(
+    AGXReader_t *r, uint32_t timeStep, const char *name, AGXParamView *out)
+{
+  AGXSplitFile &s = *r->split;
+  for (uint32_t i = 0; i < s.parts.size(); ++i) {
+    if (!coversTimeStep(s.parts[i], timeStep))
+      continue;
+    AGXReader_t *part = openPart(r, i);
+    const int rc = part ? agxReaderFindTimeStepParam(part,
+                              timeStep - s.parts[i].firstTimeStep,
+                              name,
+                              out)
+                        : -1;
+    if (rc != 0) {
+      if (rc == 1)
+        out->part = i;
+      return rc;
+    }
+  }
+  return 0;
+}
+
+static int splitReadPayload(AGXReader_t *r, void *dst, uint64_t dstBytes)
+{
+  AGXSplitFile &s = *r->split;
+  if (s.peekPart == UINT32_MAX)
+    return 1;
+  const int rc =
+      agxReaderReadPayload(s.parts[s.peekPart].reader, dst, dstBytes);
+  if (rc != 2)
+    s.peekPart = UINT32_MAX;
+  return rc;
+}
+
+// Prefetch the steps of 'first .. first + count' each part covers from it
+static int splitPrefetch(AGXReader_t *r, uint32_t first, uint32_t count)
+{
+  if (count > 0 && first >= r->hdr.timeSteps)
+    return 2;
+  const uint64_t end =
+      count > 0 ? std::min<uint64_t>(uint64_t(first) + count, r->hdr.timeSteps)
+                : 0;
+  for (uint32_t i = 0; i < r->split->parts.size(); ++i) {
+    const AGXReaderPart &p = r->split->parts[i];
+    const uint64_t partFirst = std::max<uint64_t>(first, p.firstTimeStep);
+    const uint64_t partEnd =
+        std::min<uint64_t>(end, uint64_t(p.firstTimeStep) + p.timeStepCount);
+    if (partFirst >= partEnd) {
+      if (p.reader)
+        agxReaderPrefetch(p.reader, 0, 0);
+      continue;
+    }
+    AGXReader_t *part = openPart(r, i);
+    if (!part
+        || agxReaderPrefetch(part,
+               static_cast<uint32_t>(partFirst - p.firstTimeStep),
+               static_cast<uint32_t>(partEnd - partFirst))
+            != 0)
+      return 3;
+  }
+  return 0;
+}
+
+// agxReaderPrefetchPoll() / agxReaderPrefetchWait() over the parts covering
+// time step 'index': loaded once all of them are
+static int splitPrefetchStatus(AGXReader_t *r, uint32_t index, bool wait)
+{
+  int status = -1;
+  for (const AGXReaderPart &p : r->split->parts) {
+    if (!coversTimeStep(p, index))
+      continue;
+    if (!p.reader)
+      return -1;
+    const uint32_t local = index - p.firstTimeStep;
+    const int s = wait ? agxReaderPrefetchWait(p.reader, local)
+                       : agxReaderPrefetchPoll(p.reader, local);
+    if (s < 0)
+      return -1;
+    status = status == 0 ? 0 : s;
+  }
+  return status;
+}
+
+static void addStats(AGXReaderStats &a, const AGXReaderStats &b)
+{
+  a.bytesRead += b.bytesRead;
+  a.recordsParsed += b.recordsParsed;
+  a.recordsSkipped += b.recordsSkipped;
+  a.bytesSkipped += b.bytesSkipped;
+  a.scratchReallocations += b.scratchReallocations;
+  a.openSeconds += b.openSeconds;
+  a.locateSeconds += b.locateSeconds;
+  a.payloadSeconds += b.payloadSeconds;
+  a.decodeSeconds += b.decodeSeconds;
+  a.prefetchWaitSeconds += b.prefetchWaitSeconds;
+}
+
+// Read header and compute section offsets; shared by all open paths
+static bool primeReader(AGXReader_t *r)
+{
+  AGXPhaseTimer t(&r->trace, "agx.read.open", &r->stats.openSeconds);
+  r->hostLittle = hostIsLittleEndian();
+
+  // Read header
+  char magic[4];
+  if (!readBytes(r, magic, sizeof(magic)))
+    return false;
+  if (std::memcmp(magic, "AGXM", 4) == 0)
+    return primeSplit(r);
+  if (std::memcmp(magic, "AGXB", 4) != 0)
+    return false;
+
+  uint32_t version = 0;
+  uint32_t endianMarker = 0;
+  uint32_t objectType = ANARI_UNKNOWN; // default in case of early error
+  uint32_t timeSteps = 0;
+  uint32_t constCount = 0;
+
+  if (!readU32(r, version, false) || !readU32(r, endianMarker, false)
+      || !readU32(r, objectType, false) || !readU32(r, timeSteps, false)
+      || !readU32(r, constCount, false)) {
+    return false;
+  }
+
+  bool fileLittle = true;
+  bool needSwap = false;
+  if (endianMarker == 0x01020304u) {
+    fileLittle = r->hostLittle; // same as host
+    needSwap = false;
+  } else if (bswap32(endianMarker) == 0x01020304u) {
+    fileLittle = !r->hostLittle;
+    needSwap = true;
+  } else {
+    // Invalid endian marker
+    return false;
+  }
+
+  r->fileLittle = fileLittle;
+  r->needSwap = needSwap;
+
+  // If needSwap is true, swap the header integers we just read (except
+  // endianMarker which we keep as file value)
+  if (r->needSwap) {
+    version = bswap32(version);
+    objectType = bswap32(objectType);
+    timeSteps = bswap32(timeSteps);
+    constCount = bswap32(constCount);
+  }
+
+  if (version > AGX_READER_MAX_VERSION)
+    return false;
+
+  r->hdr.version = version;
+  r->hdr.objectType = static_cast<ANARIDataType>(objectType);
+  r->hdr.timeSteps = timeSteps;
+  r->hdr.constantParamCount = constCount;
+  r->hdr.endianMarker = endianMarker;
+  r->hdr.hostLittleEndian = r->hostLittle ? 1 : 0;
+  r->hdr.fileLittleEndian = r->fileLittle ? 1 : 0;
+  r->hdr.needByteSwap = r->needSwap ? 1 : 0;
+  r->hdr.reserved = 0;
+
+  // Read optional subtype string
+  uint32_t subtypeLen = 0;
+  if (!readU32(r, subtypeLen, r->needSwap)) {
+    return false;
+  }
+  if (subtypeLen > 0) {
+    r->subtype.resize(subtypeLen);
+    if (!readBytes(r, r->subtype.data(), subtypeLen)) {
+      return false;
+    }
+  } else {
+    r->subtype.clear();
+  }
+
+  // Mark constantsStart; timeStepsStart is resolved lazily
+  r->constantsStart = tellPos(r);
+
+  // Initialize iteration positions
+  agxReaderResetConstants(r);
+
+  return true;
+}
+
+extern "C" {
+
+// Open and prime reader: read header and compute section offsets
+AGXReader agxNewReader(const char *filename)
+{
+  if (!filename)
+    return nullptr;
+  std::FILE *f = std::fopen(filename, "rb");
+  if (!f)
+    return nullptr;
+
+  AGXReader_t *r = new (std::nothrow) AGXReader_t{};
+  if (!r) {
+    std::fclose(f);
+    return nullptr;
+  }
+  r->f = f;
+  r->filename = filename;
+
+  if (!primeReader(r)) {
+    agxReleaseReader(r);
+    return nullptr;
+  }
+
+  return r;
+}
+
+AGXReader agxNewReaderWithIO(const char *filename, AGXIOBackend backend)
+{
+  if (backend != AGX_IO_DIRECT)
+    return backend == AGX_IO_STDIO ? agxNewReader(filename) : nullptr;
+  if (!filename)
+    return nullptr;
+
+  AGXReader_t *r = new (std::nothrow) AGXReader_t{};
+  if (!r)
+    return nullptr;
+  r->direct.reset(new (std::nothrow) AGXDirectReader);
+  if (!r->direct || !r->direct->open(filename)) {
+    delete r;
+    return agxNewReader(filename); // not supported for this file, use stdio
+  }
+  r->fd = r->direct->fd;
+  r->filename = filename;
+
+  if (!primeReader(r)) {
+    agxReleaseReader(r);
+    return nullptr;
+  }
+
+  return r;
+}
+
+AGXReader agxNewReaderMapped(const char *filename)
+{
+  if (!filename)
+    return nullptr;
+
+  AGXReader_t *r = new (std::nothrow) AGXReader_t{};
+  if (!r)
+    return nullptr;
+  r->filename = filename;
+
+  if (!mapFile(r, filename) || !primeReader(r)) {
+    agxReleaseReader(r);
+    return nullptr;
+  }
+
+  return r;
+}
+
+void agxReleaseReader(AGXReader r_)
+{
+  if (!r_)
+    return;
+  stopPrefetcher(r_);
+  if (r_->f)
+    std::fclose(r_->f);
+  unmapFile(r_);
+  delete r_;
+}
+
+int agxReaderGetHeader(AGXReader r_, AGXHeader *out)
+{
+  if (!r_ || !out)
+    return 1;
+  if (r_->split)
+    return splitGetHeader(r_, out);
+  *out = r_->hdr;
+  return 0;
+}
+
+void agxReaderSetConvertByteOrder(AGXReader r_, int enable)
+{
+  if (!r_)
+    return;
+  r_->convertByteOrder = enable != 0;
+  if (r_->split) {
+    for (auto &p : r_->split->parts)
+      agxReaderSetConvertByteOrder(p.reader, enable);
+  }
+}
+
+void agxSwapBytes(void *data, uint64_t bytes, ANARIDataType type)
+{
+  const size_t lane = swapLaneBytes(type);
+  if (!data || lane == 0)
+    return;
+  uint8_t *p = static_cast<uint8_t *>(data);
+  swapLanes(p, p, static_cast<size_t>(bytes), lane);
+}
+
+void agxReaderSetDequantize(AGXReader r_, int enable)
+{
+  if (!r_)
+    return;
+  r_->dequantize = enable != 0;
+  if (r_->split) {
+    for (auto &p : r_->split->parts)
+      agxReaderSetDequantize(p.reader, enable);
+  }
+}
+
+const char *agxReaderGetSubtype(AGXReader r)
+{
+  return r->subtype.c_str();
+}
+
+// Constants iteration
+void agxReaderResetConstants(AGXReader r_)
+{
+  if (r_ && r_->split) {
+    splitResetConstants(r_);
+    return;
+  }
+  if (!r_ || !isOpen(r_))
+    return;
+  seekPos(r_, r_->constantsStart);
+  r_->peeked = false;
+  r_->constantsRead = 0;
+  r_->lastName.clear();
+  r_->lastData.clear();
+}
+
+int agxReaderNextConstant(AGXReader r_, AGXParamView *out)
+{
+  if (!r_ || !isOpen(r_) || !out)
+    return -1;
+  if (r_->split)
+    return splitConstant(r_, out, false);
+  if (r_->constantsRead >= r_->hdr.constantParamCount)
+    return 0;
 
   AGXParamView v{};
-  if (!readParamRecord(r_, &v))
+  if (!cancelPeek(r_) || !readParamRecord(r_, &v))
     return -1;
 
   r_->constantsRead++;
@@ -483,9 +3161,15 @@ int agxReaderNextConstant(AGXReader r_, AGXParamView *out)
 // Time steps iteration
 void agxReaderResetTimeSteps(AGXReader r_)
 {
-  if (!r_ || !r_->f)
+  if (r_ && r_->split) {
+    splitResetTimeSteps(r_);
     return;
-  std::fseek(r_->f, r_->timeStepsStart, SEEK_SET);
+  }
+  if (!r_ || !isOpen(r_))
+    return;
+  r_->stepsPending =
+      !ensureTimeStepsStart(r_) || !seekPos(r_, r_->timeStepsStart);
+  r_->peeked = false;
   r_->stepsRead = 0;
   r_->inStep = false;
   r_->curStepIndex = 0;
@@ -498,16 +3182,24 @@ void agxReaderResetTimeSteps(AGXReader r_)
 int agxReaderBeginNextTimeStep(
     AGXReader r_, uint32_t *outIndex, uint32_t *outParamCount)
 {
-  if (!r_ || !r_->f || !outIndex || !outParamCount)
+  if (!r_ || !isOpen(r_) || !outIndex || !outParamCount)
     return -1;
+  if (r_->split)
+    return splitBeginNextTimeStep(r_, outIndex, outParamCount);
+  if (r_->stepsPending) {
+    agxReaderResetTimeSteps(r_);
+    if (r_->stepsPending)
+      return -1;
+  }
   if (r_->stepsRead >= r_->hdr.timeSteps)
     return 0;
+  if (!cancelPeek(r_))
+    return -1;
+  usePrefetchedStep(r_);
 
   uint32_t index = 0;
   uint32_t paramCount = 0;
-  if (!readU32(r_->f, index, r_->needSwap))
-    return -1;
-  if (!readU32(r_->f, paramCount, r_->needSwap))
+  if (!readStepHeader(r_, index, paramCount))
     return -1;
 
   r_->inStep = true;
@@ -523,8 +3215,10 @@ int agxReaderBeginNextTimeStep(
 
 int agxReaderNextTimeStepParam(AGXReader r_, AGXParamView *out)
 {
-  if (!r_ || !r_->f || !out)
+  if (!r_ || !isOpen(r_) || !out)
     return -1;
+  if (r_->split)
+    return splitTimeStepParam(r_, out, false);
   if (!r_->inStep)
     return 0;
   if (r_->curStepParamsRead >= r_->curStepParamCount) {
@@ -533,7 +3227,7 @@ int agxReaderNextTimeStepParam(AGXReader r_, AGXParamView *out)
   }
 
   AGXParamView v{};
-  if (!readParamRecord(r_, &v))
+  if (!cancelPeek(r_) || !readParamRecord(r_, &v))
     return -1;
 
   r_->curStepParamsRead++;
@@ -547,10 +3241,139 @@ int agxReaderNextTimeStepParam(AGXReader r_, AGXParamView *out)
   return 1;
 }
 
+int agxReaderSeekTimeStep(AGXReader r_, uint32_t index)
+{
+  if (!r_ || !isOpen(r_))
+    return 1;
+  if (r_->split)
+    return splitSeekTimeStep(r_, index);
+  if (index >= r_->hdr.timeSteps)
+    return 2;
+  if (!buildStepIndex(r_) || !seekPos(r_, r_->stepRecords[index].offset))
+    return 3;
+
+  r_->stepsRead = index;
+  r_->stepsPending = false;
+  r_->peeked = false;
+  r_->inStep = false;
+  r_->curStepIndex = 0;
+  r_->curStepParamCount = 0;
+  r_->curStepParamsRead = 0;
+  return 0;
+}
+
+// ensureStepTimes() without moving the iteration position
+static bool loadStepTimes(AGXReader_t *r)
+{
+  if (r->stepTimes.size() == r->hdr.timeSteps)
+    return true;
+  if (!cancelPeek(r))
+    return false;
+  const uint64_t pos = tellPos(r);
+  const bool ok = ensureStepTimes(r);
+  return seekPos(r, pos) && ok;
+}
+
+int agxReaderGetTimeStepTime(AGXReader r_, uint32_t index, double *outTime)
+{
+  if (!r_ || !isOpen(r_) || !outTime || index >= r_->hdr.timeSteps)
+    return 1;
+  if (!loadStepTimes(r_))
+    return 2;
+  *outTime = r_->stepTimes[index];
+  return 0;
+}
+
+int agxReaderFindTimeStepInterval(AGXReader r_,
+    double time,
+    uint32_t *outFirst,
+    uint32_t *outSecond,
+    double *outWeight)
+{
+  if (!r_ || !isOpen(r_) || !outFirst || !outSecond || !outWeight
+      || r_->hdr.timeSteps == 0)
+    return 1;
+  if (!loadStepTimes(r_))
+    return 2;
+
+  const std::vector<double> &times = r_->stepTimes;
+  const size_t next =
+      std::upper_bound(times.begin(), times.end(), time) - times.begin();
+  if (next == 0 || next == times.size()) {
+    *outFirst = *outSecond = next == 0 ? 0 : r_->hdr.timeSteps - 1;
+    *outWeight = 0.0;
+    return 0;
+  }
+  const double t0 = times[next - 1];
+  const double t1 = times[next];
+  *outFirst = static_cast<uint32_t>(next - 1);
+  *outSecond = static_cast<uint32_t>(next);
+  *outWeight = t1 > t0 ? (time - t0) / (t1 - t0) : 0.0;
+  return 0;
+}
+
+int agxReaderInterpolateArray(AGXReader r_,
+    const char *name,
+    double time,
+    void *dst,
+    uint64_t dstBytes)
+{
+  if (!r_ || !isOpen(r_) || !name || !dst
+      || (r_->needSwap && !r_->convertByteOrder))
+    return 1;
+  uint32_t first = 0;
+  uint32_t second = 0;
+  double weight = 0.0;
+  const int found =
+      agxReaderFindTimeStepInterval(r_, time, &first, &second, &weight);
+  if (found != 0)
+    return found == 1 ? 1 : 3;
+
+  // The first step's array is copied out before the second one's view
+  // replaces it
+  AGXParamView a{};
+  int rc = agxReaderFindTimeStepParam(r_, first, name, &a);
+  if (rc <= 0)
+    return rc == 0 ? 2 : 3;
+  const size_t lane = a.isArray ? lerpComponentBytes(a.elementType) : 0;
+  if (lane == 0 || dstBytes < a.dataBytes)
+    return 1;
+  const AGXReader_t *source = viewSource(r_, &a);
+  if (source->needSwap && !source->convertByteOrder)
+    return 1; // a part of a split file
+  if (a.dataBytes > 0)
+    std::memcpy(dst, a.data, static_cast<size_t>(a.dataBytes));
+  if (first == second || weight == 0.0 || a.dataBytes == 0)
+    return 0;
+
+  const uint64_t elementCount = a.elementCount;
+  const ANARIDataType elementType = a.elementType;
+  AGXParamView b{};
+  rc = agxReaderFindTimeStepParam(r_, second, name, &b);
+  if (rc <= 0)
+    return rc == 0 ? 2 : 3;
+  if (!b.isArray || b.elementType != elementType
+      || b.elementCount != elementCount)
+    return 1;
+
+  const size_t n = static_cast<size_t>(b.dataBytes) / lane;
+  const uint8_t *src = static_cast<const uint8_t *>(b.data);
+  if (lane == 4)
+    lerpFloats(static_cast<float *>(dst), src, n, static_cast<float>(weight));
+  else
+    lerpDoubles(static_cast<double *>(dst), src, n, weight);
+  return 0;
+}
+
 void agxReaderSkipRemainingTimeStep(AGXReader r_)
 {
-  if (!r_ || !r_->f || !r_->inStep)
+  if (!r_ || !isOpen(r_) || !r_->inStep)
+    return;
+  if (r_->split) {
+    splitSkipRemainingTimeStep(r_);
     return;
+  }
+  cancelPeek(r_);
   while (r_->curStepParamsRead < r_->curStepParamCount) {
     if (!skipParamRecord(r_))
       break;
@@ -559,5 +3382,561 @@ void agxReaderSkipRemainingTimeStep(AGXReader r_)
   r_->inStep = false;
 }
 
+int agxReaderFindConstant(AGXReader r_, const char *name, AGXParamView *out)
+{
+  if (r_ && r_->split && name && out)
+    return splitFindConstant(r_, name, out);
+  if (!r_ || !isOpen(r_) || !name || !out || !cancelPeek(r_))
+    return -1;
+
+  const uint64_t pos = tellPos(r_);
+  int rc = buildNameIndex(r_,
+               r_->constantNames,
+               r_->constantsStart,
+               r_->hdr.constantParamCount)
+      ? findRecord(r_, r_->constantNames, name, out)
+      : -1;
+  if (!seekPos(r_, pos))
+    rc = -1;
+  return rc;
+}
+
+int agxReaderFindTimeStepParam(
+    AGXReader r_, uint32_t timeStep, const char *name, AGXParamView *out)
+{
+  if (!r_ || !isOpen(r_) || !name || !out || !cancelPeek(r_))
+    return -1;
+  if (timeStep >= r_->hdr.timeSteps)
+    return 0;
+  if (r_->split)
+    return splitFindTimeStepParam(r_, timeStep, name, out);
+
+  const uint64_t pos = tellPos(r_);
+  int rc = -1;
+  if (buildStepIndex(r_)) {
+    r_->stepNames.resize(r_->hdr.timeSteps);
+    AGXNameIndex &index = r_->stepNames[timeStep];
+    uint32_t stepIndex = 0;
+    uint32_t paramCount = 0;
+    const bool indexed = index.built
+        || (seekPos(r_, r_->stepRecords[timeStep].offset)
+            && readStepHeader(r_, stepIndex, paramCount)
+            && buildNameIndex(r_, index, tellPos(r_), paramCount));
+    if (indexed)
+      rc = findRecord(r_, index, name, out);
+  }
+  if (!seekPos(r_, pos))
+    rc = -1;
+  return rc;
+}
+
+int agxReaderPeekConstant(AGXReader r_, AGXParamView *out)
+{
+  if (!r_ || !isOpen(r_) || !out)
+    return -1;
+  if (r_->split)
+    return splitConstant(r_, out, true);
+  if (r_->constantsRead >= r_->hdr.constantParamCount)
+    return 0;
+  return peekRecord(r_, out, true);
+}
+
+int agxReaderPeekTimeStepParam(AGXReader r_, AGXParamView *out)
+{
+  if (!r_ || !isOpen(r_) || !out)
+    return -1;
+  if (r_->split)
+    return splitTimeStepParam(r_, out, true);
+  if (!r_->inStep || r_->curStepParamsRead >= r_->curStepParamCount)
+    return 0;
+  return peekRecord(r_, out, false);
+}
+
+int agxReaderReadPayload(AGXReader r_, void *dst, uint64_t dstBytes)
+{
+  if (r_ && r_->split)
+    return splitReadPayload(r_, dst, dstBytes);
+  if (!r_ || !isOpen(r_) || !r_->peeked)
+    return 1;
+  const AGXRecordInfo info = r_->peekInfo;
+  const uint64_t bytes = producedBytes(r_, info);
+  if (dstBytes < bytes || (!dst && bytes > 0))
+    return 2;
+
+  r_->peeked = false;
+  AGXPhaseTimer t(&r_->trace, "agx.read.payload", &r_->stats.payloadSeconds);
+  bool ok = false;
+  if (dequantizes(r_, info)) {
+    // The stored array is decoded into the reader's buffers first
+    const void *stored = nullptr;
+    ok = readRecordPayload(r_, info, r_->peekOffset, &stored);
+    if (ok) {
+      dequantizeArray(r_,
+          info,
+          static_cast<const uint8_t *>(stored),
+          info.elementCount,
+          static_cast<uint8_t *>(dst));
+    }
+  } else {
+    ok = readRecordPayloadInto(r_, info, r_->peekOffset, dst);
+  }
+  if (ok && convertsByteOrder(r_) && !dequantizes(r_, info)) {
+    AGXPhaseTimer d(&r_->trace, "agx.read.decode", &r_->stats.decodeSeconds);
+    const size_t lane = swapLaneBytes(producedType(r_, info));
+    if (lane != 0)
+      swapLanes(static_cast<uint8_t *>(dst),
+          static_cast<const uint8_t *>(dst),
+          static_cast<size_t>(info.dataBytes),
+          lane);
+  }
+  if (r_->peekedConstant)
+    r_->constantsRead++;
+  else if (++r_->curStepParamsRead >= r_->curStepParamCount)
+    r_->inStep = false;
+  return ok ? 0 : 3;
+}
+
+// Whether the array of 'info' can be read as a grid of 'shape': a single row
+// (range reads) or its own dimensions
+static bool matchesShape(const AGXRecordInfo &info, const uint64_t *shape)
+{
+  if (shape[0] == info.elementCount && shape[1] == 1 && shape[2] == 1)
+    return true;
+  return std::memcmp(shape, info.numItems, sizeof(info.numItems)) == 0;
+}
+
+// Decode the box 'first' / 'count' of the elements of the array 'view' was
+// filled with, laid out as a grid of 'shape' (x fastest; a single row for
+// range reads), into 'dst', packed. Runs of elements contiguous in the array
+// (whole rows or planes) are read at once. Returns as agxReaderReadArrayBox().
+static int readArrayBox(AGXReader_t *r,
+    const AGXParamView *view,
+    const uint64_t *shape,
+    const uint64_t *first,
+    const uint64_t *count,
+    void *dst)
+{
+  AGXPhaseTimer t(&r->trace, "agx.read.payload", &r->stats.payloadSeconds);
+  const uint64_t pos = tellPos(r);
+  AGXRecordInfo info;
+  if (!seekPos(r, view->recordOffset) || !readRecordHeader(r, info, false)
+      || !(info.flags & AGX_RECORD_FLAG_ARRAY)
+      || info.elementCount != view->elementCount
+      || producedBytes(r, info) != view->dataBytes
+      || !matchesShape(info, shape)) {
+    seekPos(r, pos);
+    return 2;
+  }
+
+  // Runs of 'runLength' elements, 'runs[1]' per plane and 'runs[2]' planes
+  uint64_t runLength = count[0];
+  uint64_t runs[3] = {1, count[1], count[2]};
+  if (count[0] == shape[0]) {
+    runLength *= count[1];
+    runs[1] = 1;
+    if (count[1] == shape[1]) {
+      runLength *= count[2];
+      runs[2] = 1;
+    }
+  }
+  const uint64_t total = count[0] * count[1] * count[2];
+
+  // Elements of quantized arrays are read as stored, then restored into 'dst'
+  const uint64_t elementBytes =
+      info.elementCount ? info.dataBytes / info.elementCount : 0;
+  const size_t n = static_cast<size_t>(total * elementBytes);
+  const size_t runBytes = static_cast<size_t>(runLength * elementBytes);
+  const bool dequantize = dequantizes(r, info);
+  if (dequantize)
+    resizeScratch(r, r->quantScratch, n);
+  uint8_t *out =
+      dequantize ? r->quantScratch.data() : static_cast<uint8_t *>(dst);
+  const uint64_t payloadOffset = tellPos(r);
+
+  // Call 'read' with the first element of each run and where it goes
+  bool ok = true;
+  auto readRuns = [&](auto &&read) {
+    uint8_t *o = out;
+    for (uint64_t z = 0; ok && z < runs[2]; ++z) {
+      for (uint64_t y = 0; ok && y < runs[1]; ++y, o += runBytes) {
+        const uint64_t row = (first[2] + z) * shape[1] + first[1] + y;
+        ok = read(row * shape[0] + first[0], o);
+      }
+    }
+  };
+  if (n == 0) {
+    // nothing to read
+  } else if (info.flags & AGX_RECORD_FLAG_CHUNKED) {
+    ok = readChunkIndex(r, info);
+    readRuns([&](uint64_t start, uint8_t *o) {
+      return copyChunkRange(r, info, payloadOffset, start, runLength, o);
+    });
+  } else if (isStoredRaw(info)) {
+    readRuns([&](uint64_t start, uint8_t *o) {
+      return seekPos(r, payloadOffset + start * elementBytes)
+          && readBytes(r, o, runBytes);
+    });
+  } else {
+    // Compressed, delta-coded and deduplicated arrays are decoded in full;
+    // delta chains continue from the per-name cache like iteration does
+    const void *data = nullptr;
+    if (info.flags & AGX_RECORD_FLAG_REF) {
+      ok = resolveRef(r, info, view->recordOffset, &data);
+    } else if (info.flags & AGX_RECORD_FLAG_DELTA) {
+      std::string name;
+      ok = readRecordName(r, view->recordOffset, name);
+      AGXDecodedArray &a = r->deltaCache[name];
+      ok = ok && decodeArrayPayload(r, info, a, view->recordOffset);
+      data = a.bytes.data();
+    } else {
+      ok = readDecodedPayload(r, info, r->rangeScratch);
+      data = r->rangeScratch.data();
+    }
+    const uint8_t *decoded = static_cast<const uint8_t *>(data);
+    readRuns([&](uint64_t start, uint8_t *o) {
+      std::memcpy(o, decoded + start * elementBytes, runBytes);
+      return true;
+    });
+  }
+  if (ok && n > 0 && dequantize) {
+    dequantizeArray(r, info, out, total, static_cast<uint8_t *>(dst));
+  } else if (ok && n > 0 && convertsByteOrder(r)) {
+    AGXPhaseTimer d(&r->trace, "agx.read.decode", &r->stats.decodeSeconds);
+    const size_t lane = swapLaneBytes(producedType(r, info));
+    if (lane != 0)
+      swapLanes(out, out, n, lane);
+  }
+  return seekPos(r, pos) && ok ? 0 : 2;
+}
+
+// Whether 'first' / 'count' is a box within the array of 'view'
+static bool isArrayBox(
+    const AGXParamView *view, const uint64_t *first, const uint64_t *count)
+{
+  if (!view || !view->isArray || !first || !count)
+    return false;
+  for (int d = 0; d < 3; ++d) {
+    if (first[d] > view->numItems[d]
+        || count[d] > view->numItems[d] - first[d])
+      return false;
+  }
+  return true;
+}
+
+int agxReaderReadArrayRange(AGXReader r_,
+    const AGXParamView *view,
+    uint64_t firstElement,
+    uint64_t count,
+    void *dst)
+{
+  if (r_ && r_->split) {
+    AGXReader_t *part = viewSource(r_, view);
+    return part ? agxReaderReadArrayRange(part, view, firstElement, count, dst)
+                : 1;
+  }
+  if (!r_ || !isOpen(r_) || !view || !view->isArray
+      || firstElement > view->elementCount
+      || count > view->elementCount - firstElement || (!dst && count > 0))
+    return 1;
+  const uint64_t shape[3] = {view->elementCount, 1, 1};
+  const uint64_t first[3] = {firstElement, 0, 0};
+  const uint64_t counts[3] = {count, 1, 1};
+  return readArrayBox(r_, view, shape, first, counts, dst);
+}
+
+int agxReaderReadArrayBox(AGXReader r_,
+    const AGXParamView *view,
+    const uint64_t first[3],
+    const uint64_t count[3],
+    void *dst)
+{
+  if (r_ && r_->split) {
+    AGXReader_t *part = viewSource(r_, view);
+    return part ? agxReaderReadArrayBox(part, view, first, count, dst) : 1;
+  }
+  if (!r_ || !isOpen(r_) || !isArrayBox(view, first, count))
+    return 1;
+  if (!dst && count[0] * count[1] * count[2] > 0)
+    return 1;
+  return readArrayBox(r_, view, view->numItems, first, count, dst);
+}
+
+int agxReaderViewArrayBox(AGXReader r_,
+    const AGXParamView *view,
+    const uint64_t first[3],
+    const uint64_t count[3],
+    AGXArrayBoxView *out)
+{
+  if (r_ && r_->split) {
+    AGXReader_t *part = viewSource(r_, view);
+    return part ? agxReaderViewArrayBox(part, view, first, count, out) : 1;
+  }
+  if (!r_ || !isOpen(r_) || !isArrayBox(view, first, count) || !out)
+    return 1;
+  if (!r_->map || convertsByteOrder(r_))
+    return 2;
+
+  const uint64_t pos = tellPos(r_);
+  AGXRecordInfo info;
+  if (!seekPos(r_, view->recordOffset) || !readRecordHeader(r_, info, false)
+      || !(info.flags & AGX_RECORD_FLAG_ARRAY)
+      || info.elementCount != view->elementCount
+      || producedBytes(r_, info) != view->dataBytes
+      || !matchesShape(info, view->numItems)) {
+    seekPos(r_, pos);
+    return 3;
+  }
+
+  // Raw arrays in the mapping, and references resolving to one
+  int rc = 2;
+  const void *data = nullptr;
+  if (dequantizes(r_, info)) {
+    // restored into a buffer
+  } else if (info.flags & AGX_RECORD_FLAG_REF) {
+    if (!resolveRef(r_, info, view->recordOffset, &data))
+      rc = 3;
+    else if (static_cast<const uint8_t *>(data) >= r_->map
+        && static_cast<const uint8_t *>(data) < r_->map + r_->mapSize)
+      rc = 0;
+  } else if (isStoredRaw(info)) {
+    data = viewBytes(r_, info.dataBytes);
+    rc = data ? 0 : 3;
+  }
+  if (!seekPos(r_, pos))
+    rc = 3;
+  if (rc != 0)
+    return rc;
+
+  const uint64_t elementBytes =
+      info.elementCount ? info.dataBytes / info.elementCount : 0;
+  out->stride[0] = elementBytes;
+  out->stride[1] = elementBytes * view->numItems[0];
+  out->stride[2] = out->stride[1] * view->numItems[1];
+  uint64_t offset = 0;
+  for (int d = 0; d < 3; ++d) {
+    out->count[d] = count[d];
+    offset += first[d] * out->stride[d];
+  }
+  out->data = static_cast<const uint8_t *>(data) + offset;
+  return 0;
+}
+
+AGXReader agxReaderNewCursor(AGXReader r_)
+{
+  if (!r_ || !isOpen(r_))
+    return nullptr;
+  if (r_->split) {
+    // Parts are opened by the cursor itself, so it shares no state with 'r'
+    const char *filename = r_->filename.c_str();
+    AGXReader_t *c = r_->split->mapped
+        ? agxNewReaderMapped(filename)
+        : agxNewReaderWithIO(filename, r_->split->backend);
+    if (c) {
+      c->convertByteOrder = r_->convertByteOrder;
+      c->dequantize = r_->dequantize;
+    }
+    return c;
+  }
+
+  // Locate everything up front, so the shared state is complete
+  const uint64_t pos = tellPos(r_);
+  const bool located = buildStepIndex(r_);
+  if (!seekPos(r_, pos) || !located)
+    return nullptr;
+
+  AGXReader_t *c = new (std::nothrow) AGXReader_t{};
+  if (!c)
+    return nullptr;
+  c->parent = r_;
+  c->filename = r_->filename;
+  if (r_->map) {
+    c->map = r_->map;
+    c->mapSize = r_->mapSize;
+  } else {
+#ifdef _WIN32
+    c->f = std::fopen(r_->filename.c_str(), "rb");
+#else
+    c->fd = r_->fd >= 0 ? r_->fd : fileno(r_->f);
+    if (r_->direct) {
+      c->direct.reset(new (std::nothrow) AGXDirectReader);
+      if (!c->direct || !c->direct->open(nullptr, c->fd))
+        c->fd = -1;
+    }
+#endif
+  }
+  if (!isOpen(c)) {
+    delete c;
+    return nullptr;
+  }
+
+  c->hostLittle = r_->hostLittle;
+  c->fileLittle = r_->fileLittle;
+  c->needSwap = r_->needSwap;
+  c->convertByteOrder = r_->convertByteOrder;
+  c->dequantize = r_->dequantize;
+  c->hdr = r_->hdr;
+  c->subtype = r_->subtype;
+  c->constantsStart = r_->constantsStart;
+  c->timeStepsStart = r_->timeStepsStart;
+  c->timeStepsStartKnown = r_->timeStepsStartKnown;
+  c->tocLoaded = r_->tocLoaded;
+  c->hasToc = r_->hasToc;
+  c->stepIndexBuilt = r_->stepIndexBuilt;
+  c->constantRecords = r_->constantRecords;
+  c->stepRecords = r_->stepRecords;
+  c->stepTimes = r_->stepTimes;
+  agxReaderResetConstants(c);
+  return c;
+}
+
+int agxReaderPrefetch(AGXReader r_, uint32_t first, uint32_t count)
+{
+  if (!r_ || !isOpen(r_))
+    return 1;
+  if (r_->split)
+    return splitPrefetch(r_, first, count);
+  if (count > 0 && first >= r_->hdr.timeSteps)
+    return 2;
+  count = count > 0 ? std::min(count, r_->hdr.timeSteps - first) : 0;
+
+  // Locating the steps may move the file position
+  const uint64_t pos = tellPos(r_);
+  const bool located = count == 0 || buildStepIndex(r_);
+  if (!seekPos(r_, pos) || !located)
+    return 3;
+
+  if (!r_->prefetch) {
+    if (count == 0)
+      return 0;
+    r_->prefetch.reset(new (std::nothrow) AGXPrefetcher);
+    if (!r_->prefetch)
+      return 3;
+    r_->prefetch->filename = r_->filename;
+    r_->prefetch->map = r_->map;
+    r_->prefetch->worker = std::thread(prefetchWorker, r_->prefetch.get());
+  }
+
+  AGXPrefetcher &p = *r_->prefetch;
+  {
+    std::lock_guard<std::mutex> lock(p.mutex);
+
+    // Drop what is no longer requested
+    std::vector<uint8_t> have(count, 0);
+    for (auto &s : p.slots) {
+      if (s->state == AGXPrefetchSlot::EMPTY || s->dropped)
+        continue;
+      if (s->state != AGXPrefetchSlot::FAILED && s->step >= first
+          && s->step - first < count)
+        have[s->step - first] = 1;
+      else if (s->state == AGXPrefetchSlot::LOADING)
+        s->dropped = true;
+      else {
+        s->state = AGXPrefetchSlot::EMPTY;
+        s->bytes.clear();
+      }
+    }
+
+    // Queue the rest, reusing free slots
+    size_t freeSlot = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+      if (have[i])
+        continue;
+      while (freeSlot < p.slots.size()
+          && p.slots[freeSlot]->state != AGXPrefetchSlot::EMPTY)
+        freeSlot++;
+      if (freeSlot == p.slots.size())
+        p.slots.emplace_back(new AGXPrefetchSlot);
+      AGXPrefetchSlot &s = *p.slots[freeSlot];
+      s.state = AGXPrefetchSlot::QUEUED;
+      s.step = first + i;
+      s.offset = r_->stepRecords[first + i].offset;
+      s.size = r_->stepRecords[first + i].size;
+    }
+
+    // Keep the ring bounded
+    while (p.slots.size() > count
+        && p.slots.back()->state == AGXPrefetchSlot::EMPTY)
+      p.slots.pop_back();
+  }
+  p.changed.notify_all();
+  return 0;
+}
+
+int agxReaderPrefetchPoll(AGXReader r_, uint32_t index)
+{
+  if (r_ && r_->split)
+    return splitPrefetchStatus(r_, index, false);
+  if (!r_ || !r_->prefetch)
+    return -1;
+  std::lock_guard<std::mutex> lock(r_->prefetch->mutex);
+  return prefetchStatus(findPrefetchSlot(*r_->prefetch, index));
+}
+
+int agxReaderPrefetchWait(AGXReader r_, uint32_t index)
+{
+  if (r_ && r_->split)
+    return splitPrefetchStatus(r_, index, true);
+  if (!r_ || !r_->prefetch)
+    return -1;
+  AGXPrefetcher &p = *r_->prefetch;
+  AGXPhaseTimer t(
+      &r_->trace, "agx.read.prefetchWait", &r_->stats.prefetchWaitSeconds);
+  std::unique_lock<std::mutex> lock(p.mutex);
+  int status = -1;
+  p.changed.wait(lock, [&]() {
+    status = prefetchStatus(findPrefetchSlot(p, index));
+    return status != 0;
+  });
+  return status;
+}
+
+int agxReaderGetStats(AGXReader r_, AGXReaderStats *out)
+{
+  if (!r_ || !out)
+    return 1;
+  *out = r_->stats;
+  if (r_->split) {
+    for (const auto &p : r_->split->parts) {
+      if (p.reader)
+        addStats(*out, p.reader->stats);
+    }
+  }
+  return 0;
+}
+
+void agxReaderResetStats(AGXReader r_)
+{
+  if (!r_)
+    return;
+  r_->stats = AGXReaderStats{};
+  if (r_->split) {
+    for (auto &p : r_->split->parts)
+      agxReaderResetStats(p.reader);
+  }
+}
+
+void agxReaderSetTraceHooks(AGXReader r_,
+    AGXTraceBeginCallback begin,
+    AGXTraceEndCallback end,
+    const void *userData)
+{
+  if (!r_)
+    return;
+  r_->trace.begin = begin;
+  r_->trace.end = end;
+  r_->trace.userData = userData;
+  if (r_->split) {
+    for (auto &p : r_->split->parts)
+      agxReaderSetTraceHooks(p.reader, begin, end, userData);
+  }
+}
+
+const char *agxReaderGetPartFilename(AGXReader r_, uint32_t part)
+{
+  if (!r_ || !r_->split || part >= r_->split->parts.size())
+    return nullptr;
+  return r_->split->parts[part].filename.c_str();
+}
+
 } // extern "C"
 #endif
@@ -5,10 +5,10 @@
 
 // C-style API in C++ for animated geometry export, ANARI-style.
 
-// File format (v1, host-endian; an endianness marker is included):
+// File format (v10, host-endian; an endianness marker is included):
 //   Header:
 //     char[4]   magic = "AGXB"
-//     uint32_t  version = 1
+//     uint32_t  version = 10
 //     uint32_t  endianMarker = 0x01020304
 //     uint32_t  objectType
 //     uint32_t  timeSteps
@@ -21,8 +21,8 @@
 //   Constant parameter records (constantParamCount times):
 //     uint32_t  nameLen
 //     char[]    name (nameLen bytes, not null-terminated)
-//     uint8_t   isArray (0 = value, 1 = array)
-//     if isArray == 0:
+//     uint8_t   flags (AGX_RECORD_FLAG_*; v1/v2: isArray, 0 = value, 1 = array)
+//     if !(flags & ARRAY):
 //       uint32_t  type       (ANARIDataType)
 //       uint32_t  valueBytes (N)
 //       uint8_t[] value (N bytes)
@@ -30,13 +30,103 @@
 //       uint32_t  elementType (ANARIDataType)
 //       uint64_t  elementCount
 //       uint64_t  dataBytes (M)
-//       uint8_t[] data (M bytes; M == elementCount * sizeof(elementType))
+//       if flags & ENCODED:
+//         uint8_t   codec (AGXCodec)
+//         uint64_t  storedBytes (S)
+//       if flags & DELTA:
+//         uint8_t   deltaMode (AGX_DELTA_*)
+//         uint8_t   laneBytes (integer lane width for AGX_DELTA_ADD, else 0)
+//         uint64_t  baseOffset (file offset of the base record)
+//       if flags & REF (never combined with ENCODED or DELTA):
+//         uint64_t  refOffset (file offset of an earlier array record whose
+//                   decoded payload is these M bytes)
+//       if flags & CHUNKED (never combined with ENCODED, DELTA or REF):
+//         uint8_t   codec (AGXCodec)
+//         uint64_t  chunkElements (E, elements per chunk; the last chunk holds
+//                   the remainder)
+//         uint64_t  storedBytes (S)
+//         uint64_t[] chunkBytes (C = ceil(elementCount / E) entries: the
+//                    stored size of each chunk, which is compressed with
+//                    'codec' if that is less than the chunk's decoded size,
+//                    else raw)
+//       if flags & QUANTIZED (elementType is ANARI_FLOAT32[_VECn]; everything
+//       else describes the stored array of quantized elements, DS bytes each:
+//       M == elementCount * DS, ranges and chunks count those elements):
+//         uint8_t   quantization (AGXQuantization, which implies the stored
+//                   element type)
+//         uint8_t   boundsCount (B: components of elementType for
+//                   AGX_QUANTIZE_BOUNDS16, else 0)
+//         float[B]  boundsMin (component c = boundsMin[c] + q / 65535 *
+//         float[B]  boundsMax  (boundsMax[c] - boundsMin[c]))
+//       if flags & SHAPED (2D / 3D arrays, elements in x-fastest order):
+//         uint8_t   dimensions (D, 2 or 3)
+//         uint64_t[D] numItems (elements per dimension, product ==
+//                     elementCount)
+//       if flags & ALIGNED (only set on records with a payload):
+//         uint32_t  padBytes (P)
+//         uint8_t[] padding (P zero bytes, placing the payload at a file
+//                   offset which is a multiple of the writer's alignment)
+//       uint8_t[] payload: 0 bytes if REF, else S bytes if ENCODED
+//                 (decompressing to M bytes) or CHUNKED (the C chunks back to
+//                 back), else 0 bytes for AGX_DELTA_COPY, else M bytes (M ==
+//                 elementCount * sizeof(elementType) unless QUANTIZED); for
+//                 DELTA records the decoded payload is combined with the
+//                 decoded base array
 //
 //   For each time step (timeSteps times):
 //     uint32_t  timeStepIndex
 //     uint32_t  paramCount
+//     double    time (v8+; agxSetTimeStepTime, default timeStepIndex)
 //     paramCount parameter records (same layout as above)
 //
+//   Table of contents (v2+):
+//     char[4]   tocMagic = "AGXT"
+//     uint64_t  timeStepsStart (file offset of the first time step)
+//     uint32_t  constantCount
+//     constantCount x { uint64_t offset; uint64_t size; } (constant records)
+//     uint32_t  timeStepCount
+//     timeStepCount x { uint64_t offset; uint64_t size; } (time step blocks,
+//                                                          incl. step header)
+//     timeStepCount x double time (v8+, as in the step headers)
+//
+//   Footer (v2+, last 12 bytes of the file):
+//     uint64_t  tocOffset
+//     char[4]   footerMagic = "AGXF"
+//
+// Split manifest (agxWriteSplitManifest; same byte order rules):
+//     char[4]   magic = "AGXM"
+//     uint32_t  version = 1
+//     uint32_t  endianMarker = 0x01020304
+//     uint32_t  objectType
+//     uint32_t  timeSteps
+//     uint32_t  partCount
+//     uint32_t  subtypeLen
+//     char[]    subtype (subtypeLen bytes, not null-terminated)
+//     timeSteps x double time
+//     partCount x {
+//       uint32_t  firstTimeStep (time step of the split file which is the
+//                 part's time step 0)
+//       uint32_t  timeStepCount (time steps of the part, firstTimeStep +
+//                 timeStepCount <= timeSteps)
+//       uint32_t  pathLen
+//       char[]    path (AGXB part file, relative to the manifest's directory
+//                 unless absolute)
+//     }
+//
+// Version history:
+// - v1: initial layout
+// - v2: adds the table of contents + footer; everything before it is
+//       unchanged, so v1 readers can still parse v2 files
+// - v3: the isArray byte becomes a flags byte; arrays may be compressed
+// - v4: per-time-step arrays may be delta-encoded against the same-named array
+//       of the previous time step
+// - v5: arrays may reference an earlier record with identical content
+// - v6: arrays may be split into independently decodable chunks
+// - v7: array payloads may be padded to an alignment
+// - v8: time step headers and the TOC carry a timestamp per time step
+// - v9: arrays may be stored quantized
+// - v10: arrays may have 2 or 3 dimensions
+//
 // Notes:
 // - Values are written in host endianness; the endianMarker lets a reader
 // detect endianness.
@@ -47,6 +137,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "agx_format.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -57,6 +149,16 @@ extern "C" {
 // Opaque exporter handle
 typedef struct AGXExporter_t *AGXExporter;
 
+// Called once the exporter no longer needs memory handed to one of the
+// *Shared setters (same signature as ANARIMemoryDeleter)
+typedef void (*AGXMemoryDeleter)(const void *userData, const void *appMemory);
+
+// Allocate 'bytes' bytes, aligned to at least 16 bytes (NULL on failure) /
+// free memory returned by the matching allocate callback
+typedef void *(*AGXAllocateCallback)(const void *userData, size_t bytes);
+typedef void (*AGXFreeCallback)(
+    const void *userData, void *memory, size_t bytes);
+
 // Create/destroy exporter
 AGXExporter agxNewExporter();
 void agxReleaseExporter(AGXExporter exporter);
@@ -68,8 +170,116 @@ void agxSetObjectSubtype(AGXExporter exporter, const char *subtype);
 void agxSetTimeStepCount(AGXExporter exporter, uint32_t count);
 uint32_t agxGetTimeStepCount(AGXExporter exporter);
 
-// Optional begin/end bracketing of per-time step edits (no-op but keeps
-// ANARI-like style)
+// Timestamp of a time step (any unit, e.g. seconds), stored with the step so
+// readers can look steps up by time and interpolate between them (see
+// agxReaderFindTimeStepInterval); this replaces a per-step "time" parameter.
+// Timestamps should increase with the time step index. Default: the index.
+void agxSetTimeStepTime(
+    AGXExporter exporter, uint32_t timeStepIndex, double time);
+
+// Compress array payloads written from now on with 'codec' at the given
+// codec-specific 'level' (0 = codec default). Arrays which don't get smaller,
+// and all arrays when the codec isn't compiled in (see agxCodecSupported), are
+// stored raw. Default: AGX_CODEC_NONE.
+void agxSetCompression(AGXExporter exporter, AGXCodec codec, int level);
+
+// Store the ANARI_FLOAT32[_VECn] arrays named 'name' (constants and time step
+// parameters) written from now on with the lossy encoding 'mode', in half the
+// bytes before compression:
+// - AGX_QUANTIZE_FLOAT16 rounds each component to a half float (11 significant
+//   bits, magnitudes up to 65504)
+// - AGX_QUANTIZE_OCT16 keeps only the direction of ANARI_FLOAT32_VEC3 vectors
+//   (e.g. normals), as two 16-bit octahedral coordinates
+// - AGX_QUANTIZE_BOUNDS16 maps each component to 16 bits between its minimum
+//   and maximum over the array (e.g. positions, to 1/65535 of the bounding
+//   box; non-finite values are clamped)
+// Arrays the mode doesn't apply to are stored as they are. Readers restore
+// ANARI_FLOAT32 data unless asked for the stored form (agxReaderSetDequantize).
+// Quantized arrays are not delta-encoded. AGX_QUANTIZE_NONE (default) stores
+// 'name' losslessly again.
+void agxSetArrayQuantization(
+    AGXExporter exporter, const char *name, AGXQuantization mode);
+
+// Temporal delta encoding of per-time-step arrays: each array is stored as the
+// difference to the same-named array (same type and count) of the previous
+// time step -- bitwise XOR for floating point types, wrapping subtraction per
+// component for integer types -- or as a plain back-reference when its bytes
+// are identical. Deltas are compressed like any other payload. Every
+// 'keyframeInterval'-th time step (0 = only the first) is stored in full,
+// which bounds the work to decode a time step after seeking. Default: off.
+void agxSetDeltaEncoding(
+    AGXExporter exporter, int enable, uint32_t keyframeInterval);
+
+// Store arrays whose bytes repeat an earlier array of the same file (constant
+// or per-time-step, any name) as a reference to its first occurrence instead
+// of a second copy. Matches are found by content hash and confirmed by
+// comparing the bytes while both arrays are still held by the exporter.
+// Default: on.
+void agxSetDeduplication(AGXExporter exporter, int enable);
+
+// Write time step parameters whose value or array is the same in every time
+// step (type, count and bytes) once, as a constant, instead of in each time
+// step; readers then find them among the constants only. Applies to agxWrite()
+// of two or more time steps, and not to names also set as constants.
+// Streaming exports write the constants before later time steps are known, so
+// they don't promote (their repeated arrays are still written as references,
+// see agxSetDeduplication). Default: off.
+void agxSetConstantPromotion(AGXExporter exporter, int enable);
+
+// Size in bytes of the buffer which collects record headers and small
+// payloads; larger payloads are written directly, gathered with the buffered
+// bytes into one system call (0 = default, 1 MiB).
+void agxSetWriteBufferSize(AGXExporter exporter, size_t bytes);
+
+// Store arrays larger than 'chunkBytes' bytes as a sequence of chunks of about
+// that size (whole elements, at least one each), compressed one by one, with
+// an index of their sizes so readers can decode any element range by reading
+// only the chunks it overlaps (agxReaderReadArrayRange). Arrays stored as a
+// delta or as a reference to an earlier array are not chunked. 0 = off
+// (default).
+void agxSetArrayChunking(AGXExporter exporter, uint64_t chunkBytes);
+
+// Pad array records so their payloads start at file offsets which are
+// multiples of 'alignment', a power of two up to 1 MiB: e.g. 64 for aligned
+// SIMD loads or 4096 for page-aligned mapped and direct I/O reads (mapped
+// readers then return equally aligned data pointers). 0 or 1 = off (default);
+// other values are ignored.
+void agxSetPayloadAlignment(AGXExporter exporter, uint32_t alignment);
+
+// Number of threads agxWrite() uses to encode and write time steps (0 = one
+// per hardware thread). Output is identical for any thread count; streaming
+// exports and Windows builds always write on the calling thread. Default: 1.
+void agxSetWriteThreadCount(AGXExporter exporter, uint32_t threads);
+
+// Backend files are written with. AGX_IO_DIRECT (Linux) bypasses the page
+// cache with O_DIRECT, keeping several aligned 1 MiB writes in flight; files
+// which can't be opened that way (e.g. on file systems without O_DIRECT
+// support) are written with stdio, as with AGX_IO_STDIO (default). Takes
+// effect with the next agxWrite() or agxBeginStreaming(). Returns 0 on
+// success, 1 if this build doesn't support 'backend'.
+int agxSetIOBackend(AGXExporter exporter, AGXIOBackend backend);
+
+// Allocator for the memory data passed to the copying setters is copied into
+// (NULL callbacks: malloc()/free(); a NULL 'deallocate' with a non-NULL
+// 'allocate' leaves freeing to the application). The exporter takes it in
+// blocks of 64 KiB or more, shared by the values and small arrays of a section
+// (the constants or one time step); larger arrays get a block each. A
+// section's blocks are reclaimed when it is released -- for streaming exports
+// once the time step is written -- and recycled for later time steps. Must be
+// set before any data is copied. Returns 0 on success, 1 if the exporter
+// already holds copied data.
+int agxSetAllocator(AGXExporter exporter,
+    AGXAllocateCallback allocate,
+    AGXFreeCallback deallocate,
+    const void *userData);
+
+// Returns 1 if this build can compress with 'codec' (AGX_WITH_LZ4 /
+// AGX_WITH_ZSTD), 0 otherwise.
+int agxCodecSupported(AGXCodec codec);
+
+// Optional begin/end bracketing of per-time step edits (keeps ANARI-like
+// style). When streaming, agxEndTimeStep() marks the time step as complete so
+// it can be written out; otherwise both are no-ops.
 void agxBeginTimeStep(AGXExporter exporter, uint32_t timeStepIndex);
 void agxEndTimeStep(AGXExporter exporter, uint32_t timeStepIndex);
 
@@ -85,6 +295,56 @@ void agxSetParameterArray1D(AGXExporter exporter,
     const void *data,
     uint64_t elementCount);
 
+// Shared (borrowed) arrays: the exporter keeps the 'appMemory' pointer and
+// writes straight from it instead of copying. The memory must stay valid and
+// unchanged until 'deleter' is called (if non-NULL), which happens when the
+// parameter is overwritten, its time step has been streamed out, or the
+// exporter is released.
+void agxSetParameterArray1DShared(AGXExporter exporter,
+    const char *name,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint64_t elementCount,
+    AGXMemoryDeleter deleter,
+    const void *userData);
+
+// 2D and 3D arrays (as for anariNewArray2D/3D), elements in x-fastest order.
+// The dimensions are stored with the array, so readers can fetch boxes of it
+// (agxReaderReadArrayBox).
+void agxSetParameterArray2D(AGXExporter exporter,
+    const char *name,
+    ANARIDataType elementType,
+    const void *data,
+    uint64_t numItems1,
+    uint64_t numItems2);
+
+void agxSetParameterArray3D(AGXExporter exporter,
+    const char *name,
+    ANARIDataType elementType,
+    const void *data,
+    uint64_t numItems1,
+    uint64_t numItems2,
+    uint64_t numItems3);
+
+void agxSetParameterArray2DShared(AGXExporter exporter,
+    const char *name,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint64_t numItems1,
+    uint64_t numItems2,
+    AGXMemoryDeleter deleter,
+    const void *userData);
+
+void agxSetParameterArray3DShared(AGXExporter exporter,
+    const char *name,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint64_t numItems1,
+    uint64_t numItems2,
+    uint64_t numItems3,
+    AGXMemoryDeleter deleter,
+    const void *userData);
+
 // Set per-time-step parameters
 void agxSetTimeStepParameter(AGXExporter exporter,
     uint32_t timeStepIndex,
@@ -99,9 +359,141 @@ void agxSetTimeStepParameterArray1D(AGXExporter exporter,
     const void *data,
     uint64_t elementCount);
 
+void agxSetTimeStepParameterArray1DShared(AGXExporter exporter,
+    uint32_t timeStepIndex,
+    const char *name,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint64_t elementCount,
+    AGXMemoryDeleter deleter,
+    const void *userData);
+
+void agxSetTimeStepParameterArray2D(AGXExporter exporter,
+    uint32_t timeStepIndex,
+    const char *name,
+    ANARIDataType elementType,
+    const void *data,
+    uint64_t numItems1,
+    uint64_t numItems2);
+
+void agxSetTimeStepParameterArray3D(AGXExporter exporter,
+    uint32_t timeStepIndex,
+    const char *name,
+    ANARIDataType elementType,
+    const void *data,
+    uint64_t numItems1,
+    uint64_t numItems2,
+    uint64_t numItems3);
+
+void agxSetTimeStepParameterArray2DShared(AGXExporter exporter,
+    uint32_t timeStepIndex,
+    const char *name,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint64_t numItems1,
+    uint64_t numItems2,
+    AGXMemoryDeleter deleter,
+    const void *userData);
+
+void agxSetTimeStepParameterArray3DShared(AGXExporter exporter,
+    uint32_t timeStepIndex,
+    const char *name,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint64_t numItems1,
+    uint64_t numItems2,
+    uint64_t numItems3,
+    AGXMemoryDeleter deleter,
+    const void *userData);
+
 // Write out dump to a file (returns 0 on success, nonzero on error)
 int agxWrite(AGXExporter exporter, const char *filename);
 
+// Streaming export: open 'filename' up front and write each time step to it as
+// soon as it is completed with agxEndTimeStep(), releasing its data. Time steps
+// are written in index order, so a step ended early is held until all steps
+// before it are done. The header, subtype and constants are written along with
+// the first time step, so they must be set before then; edits to anything
+// already written are dropped. Returns 0 on success, nonzero on error.
+int agxBeginStreaming(AGXExporter exporter, const char *filename);
+
+// Write any remaining time steps, then the table of contents, patch the header
+// and close the file. Returns 0 on success, 3 on a write error, or 4 if edits
+// were dropped because their data had already been written.
+int agxEndStreaming(AGXExporter exporter);
+
+// Append mode: reopen the finished file 'filename' (v8+, written on a host of
+// the same byte order) to add time steps after its existing ones. Returns a
+// streaming exporter (see agxBeginStreaming) holding the file's subtype, time
+// step count and timestamps, or NULL if the file can't be opened for writing
+// or isn't a complete AGXB file. Raise the count with agxSetTimeStepCount()
+// and set the new time steps; they are written over the old table of
+// contents, and agxEndStreaming() writes a new one and patches the header.
+// The file's constants and existing time steps can't be changed (edits are
+// dropped), the first new time step is not delta-encoded and new arrays never
+// reference old ones. Output always goes through stdio. Until
+// agxEndStreaming() succeeds, readers find only the old time steps (by
+// scanning, as the table of contents is overwritten).
+AGXExporter agxOpenExporterForAppend(const char *filename);
+
+// Split files
+// A split file is a small manifest referencing part files, each an ordinary
+// AGXB file written by an exporter of its own -- e.g. one per MPI rank holding
+// the rank's piece of every time step, or one per range of time steps -- so
+// the parts can be written in parallel without gathering the data anywhere.
+// Readers open the manifest like any AGXB file (see agxReaderGetPartFilename).
+typedef struct AGXSplitPart
+{
+  const char *filename; // relative to the manifest's directory, or absolute
+  uint32_t firstTimeStep; // time step of the split file the part's step 0 is
+  uint32_t timeStepCount; // time steps of the part (agxSetTimeStepCount)
+} AGXSplitPart;
+
+// Write a manifest presenting 'parts' as one file with the subtype, time step
+// count and timestamps of 'exporter'; its parameters are not written. Parts
+// may cover any time steps, overlapping or not, and are neither opened nor
+// required to exist yet. Returns 0 on success; 1 on bad arguments (a part
+// outside the exporter's time steps), 2 if the file can't be opened, 3 on a
+// write error.
+int agxWriteSplitManifest(AGXExporter exporter,
+    const char *filename,
+    const AGXSplitPart *parts,
+    uint32_t partCount);
+
+// Statistics
+// Counters and wall time of one exporter, accumulated over all its writes
+// since it was created or agxExporterResetStats() was last called.
+typedef struct AGXExporterStats
+{
+  uint64_t bytesCopied; // data copied in by the setters
+  uint64_t bytesWritten; // handed to the output files
+  uint64_t recordsWritten;
+  uint64_t arraysDeduplicated; // written as references to earlier arrays
+  uint64_t arraysDeltaEncoded;
+  uint64_t arraysCompressed; // in full or in chunks
+  uint64_t arraysQuantized; // agxSetArrayQuantization
+  uint64_t paramsPromoted; // time step parameters written as constants
+
+  // Wall time per phase (seconds); encoding and output are part of writing
+  double copySeconds; // copying data in the setters ("agx.write.copy")
+  double writeSeconds; // agxWrite(), streamed time steps ("agx.write")
+  double encodeSeconds; // hashing, deltas, compression ("agx.write.encode")
+  double outputSeconds; // passing data to the file ("agx.write.output")
+} AGXExporterStats;
+
+// Returns 0 on success; nonzero on error. 'out' is filled on success.
+int agxExporterGetStats(AGXExporter exporter, AGXExporterStats *out);
+void agxExporterResetStats(AGXExporter exporter);
+
+// Call 'begin' and 'end' around each timed phase ("agx.write.copy",
+// "agx.write", "agx.write.encode", "agx.write.output"; the last two nest in
+// "agx.write"), on the thread calling the exporter, e.g. to show them in a
+// profiler. NULL callbacks remove the hooks.
+void agxExporterSetTraceHooks(AGXExporter exporter,
+    AGXTraceBeginCallback begin,
+    AGXTraceEndCallback end,
+    const void *userData);
+
 // Helpers
 size_t agxSizeOf(ANARIDataType type);
 const char *agxDataTypeToString(ANARIDataType type);
@@ -117,16 +509,41 @@ const char *agxDataTypeToString(ANARIDataType type);
 #ifdef AGX_WRITE_IMPL
 // anari
 #include <anari/frontend/type_utility.h>
+// compression
+#ifdef AGX_WITH_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+#ifdef AGX_WITH_ZSTD
+#include <zstd.h>
+#endif
 // std
 #include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <memory>
 #include <new>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
+// gathered and parallel writes
+#ifndef _WIN32
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+// direct I/O backend
+#include "agx_io.h"
 
 // Internal representation of parameter data
 struct ParamData
@@ -135,16 +552,479 @@ struct ParamData
   ANARIDataType type{ANARI_UNKNOWN}; // for single value
   ANARIDataType elementType{ANARI_UNKNOWN}; // for arrays
   uint64_t elementCount{0}; // for arrays
-  std::vector<uint8_t> bytes; // raw bytes
+  uint8_t dimensions{1}; // for arrays: 1, 2 or 3
+  uint64_t numItems[3]{0, 1, 1}; // for arrays, per dimension
+  // Copied data, in the arena of the section holding the parameter
+  uint8_t *bytes{nullptr};
+  size_t byteCount{0};
+  size_t byteCapacity{0};
+
+  // Borrowed application memory (*Shared setters), used instead of 'bytes'
+  const void *appMemory{nullptr};
+  uint64_t appBytes{0};
+  AGXMemoryDeleter deleter{nullptr};
+  const void *deleterUserData{nullptr};
+
+  ParamData() = default;
+  ParamData(const ParamData &) = delete;
+  ParamData &operator=(const ParamData &) = delete;
+  ParamData(ParamData &&o) noexcept
+  {
+    *this = std::move(o);
+  }
+  ParamData &operator=(ParamData &&o) noexcept
+  {
+    if (this == &o)
+      return *this;
+    releaseAppMemory();
+    isArray = o.isArray;
+    type = o.type;
+    elementType = o.elementType;
+    elementCount = o.elementCount;
+    dimensions = o.dimensions;
+    std::memcpy(numItems, o.numItems, sizeof(numItems));
+    bytes = o.bytes;
+    byteCount = o.byteCount;
+    byteCapacity = o.byteCapacity;
+    appMemory = o.appMemory;
+    appBytes = o.appBytes;
+    deleter = o.deleter;
+    deleterUserData = o.deleterUserData;
+    o.appMemory = nullptr;
+    o.deleter = nullptr;
+    return *this;
+  }
+  ~ParamData()
+  {
+    releaseAppMemory();
+  }
+
+  const uint8_t *data() const
+  {
+    return appMemory ? static_cast<const uint8_t *>(appMemory) : bytes;
+  }
+  size_t size() const
+  {
+    return appMemory ? static_cast<size_t>(appBytes) : byteCount;
+  }
+
+  void releaseAppMemory()
+  {
+    if (appMemory && deleter)
+      deleter(deleterUserData, appMemory);
+    appMemory = nullptr;
+    deleter = nullptr;
+  }
+};
+
+// Allocator of the memory parameter data is copied into (agxSetAllocator)
+struct AGXAllocator
+{
+  AGXAllocateCallback allocate{nullptr}; // nullptr: std::malloc()
+  AGXFreeCallback free{nullptr};
+  const void *userData{nullptr};
+};
+
+// Copied parameter data lives in per-section arenas made of blocks of at least
+// AGX_ARENA_BLOCK_BYTES; payloads above a quarter of that get a block of their
+// own. Allocations are AGX_ARENA_ALIGNMENT aligned.
+static const size_t AGX_ARENA_BLOCK_BYTES = size_t(64) << 10;
+static const size_t AGX_ARENA_ALIGNMENT = 16;
+
+struct AGXArenaBlock
+{
+  uint8_t *data{nullptr};
+  size_t size{0};
+  size_t used{0};
+};
+
+// Source of the arena blocks of an exporter. Blocks of released sections are
+// kept for reuse (up to twice the size of the last section released), so a
+// streaming export settles into recycling the blocks of written time steps
+// instead of allocating.
+struct AGXBlockPool
+{
+  AGXAllocator allocator;
+  std::vector<AGXArenaBlock> cached; // oldest first
+  size_t cachedBytes{0};
+  size_t liveBlocks{0}; // blocks held by arenas
+
+  AGXBlockPool() = default;
+  AGXBlockPool(const AGXBlockPool &) = delete;
+  AGXBlockPool &operator=(const AGXBlockPool &) = delete;
+  ~AGXBlockPool()
+  {
+    trim(0);
+  }
+
+  // Hand out a block of at least 'size' bytes: the smallest cached block which
+  // is no more than twice as large, else a new one
+  bool acquire(size_t size, AGXArenaBlock &out)
+  {
+    size_t best = cached.size();
+    for (size_t i = 0; i < cached.size(); ++i) {
+      const size_t s = cached[i].size;
+      if (s >= size && s / 2 <= size
+          && (best == cached.size() || s < cached[best].size))
+        best = i;
+    }
+    if (best != cached.size()) {
+      out = cached[best];
+      cached.erase(cached.begin() + best);
+      cachedBytes -= out.size;
+    } else {
+      void *p = allocator.allocate
+          ? allocator.allocate(allocator.userData, size)
+          : std::malloc(size);
+      if (!p)
+        return false;
+      out.data = static_cast<uint8_t *>(p);
+      out.size = size;
+    }
+    out.used = 0;
+    liveBlocks++;
+    return true;
+  }
+
+  // Take back all blocks of a section
+  void release(std::vector<AGXArenaBlock> &blocks)
+  {
+    size_t bytes = 0;
+    for (const auto &b : blocks) {
+      cached.push_back(b);
+      bytes += b.size;
+    }
+    cachedBytes += bytes;
+    liveBlocks -= blocks.size();
+    blocks.clear();
+    trim(2 * bytes);
+  }
+
+  // Free cached blocks, oldest first, until at most 'keepBytes' are cached
+  void trim(size_t keepBytes)
+  {
+    size_t n = 0;
+    for (; n < cached.size() && cachedBytes > keepBytes; ++n) {
+      if (allocator.free)
+        allocator.free(allocator.userData, cached[n].data, cached[n].size);
+      else if (!allocator.allocate)
+        std::free(cached[n].data);
+      cachedBytes -= cached[n].size;
+    }
+    cached.erase(cached.begin(), cached.begin() + n);
+  }
+};
+
+// Memory of the copied parameter data of one section, returned to the pool as
+// a whole when the section is released
+struct AGXArena
+{
+  AGXBlockPool *pool{nullptr};
+  std::vector<AGXArenaBlock> blocks;
+  size_t current{0}; // block small allocations are packed into
+
+  AGXArena() = default;
+  AGXArena(const AGXArena &) = delete;
+  AGXArena &operator=(const AGXArena &) = delete;
+  AGXArena(AGXArena &&o) noexcept
+  {
+    *this = std::move(o);
+  }
+  AGXArena &operator=(AGXArena &&o) noexcept
+  {
+    if (this == &o)
+      return *this;
+    release();
+    pool = o.pool;
+    blocks = std::move(o.blocks);
+    current = o.current;
+    o.blocks.clear();
+    return *this;
+  }
+  ~AGXArena()
+  {
+    release();
+  }
+
+  uint8_t *allocate(AGXBlockPool &p, size_t n)
+  {
+    pool = &p;
+    n = (n + AGX_ARENA_ALIGNMENT - 1) & ~(AGX_ARENA_ALIGNMENT - 1);
+    if (n > AGX_ARENA_BLOCK_BYTES / 4) {
+      AGXArenaBlock b;
+      if (!pool->acquire(n, b))
+        return nullptr;
+      b.used = n;
+      blocks.push_back(b);
+      return b.data;
+    }
+    if (current >= blocks.size()
+        || blocks[current].size - blocks[current].used < n) {
+      AGXArenaBlock b;
+      if (!pool->acquire(AGX_ARENA_BLOCK_BYTES, b))
+        return nullptr;
+      current = blocks.size();
+      blocks.push_back(b);
+    }
+    AGXArenaBlock &b = blocks[current];
+    uint8_t *ptr = b.data + b.used;
+    b.used += n;
+    return ptr;
+  }
+
+  void release()
+  {
+    if (pool && !blocks.empty())
+      pool->release(blocks);
+    blocks.clear();
+    current = 0;
+  }
+};
+
+// Parameter names of an exporter, each stored once and referred to by its
+// index (id) in 'names'. The deque keeps the strings in place, so 'ids' can
+// key on views of them and lookups by C string don't allocate.
+struct AGXNameTable
+{
+  std::deque<std::string> names;
+  std::unordered_map<std::string_view, uint32_t> ids;
+
+  uint32_t intern(const char *name)
+  {
+    const std::string_view key(name);
+    auto it = ids.find(key);
+    if (it != ids.end())
+      return it->second;
+    const uint32_t id = static_cast<uint32_t>(names.size());
+    names.emplace_back(key);
+    ids.emplace(names.back(), id);
+    return id;
+  }
+
+  const std::string &name(uint32_t id) const
+  {
+    return names[id];
+  }
+};
+
+struct AGXParam
+{
+  uint32_t name{0}; // id in the exporter's AGXNameTable
+  ParamData data;
+};
+
+// Parameters of one section (the constants or a time step) in the order they
+// were first set. Sections hold few parameters, so lookups scan the vector.
+struct ParamList
+{
+  std::vector<AGXParam> params;
+  AGXArena arena; // copied data of 'params'
+
+  // 'hint' is the position the parameter is expected at (time steps mostly
+  // set the same parameters in the same order)
+  const ParamData *find(uint32_t name, size_t hint = 0) const
+  {
+    if (hint < params.size() && params[hint].name == name)
+      return &params[hint].data;
+    for (const auto &p : params) {
+      if (p.name == name)
+        return &p.data;
+    }
+    return nullptr;
+  }
+
+  void set(uint32_t name, ParamData &&data)
+  {
+    for (auto &p : params) {
+      if (p.name == name) {
+        p.data = std::move(data);
+        return;
+      }
+    }
+    params.push_back(AGXParam{name, std::move(data)});
+  }
+
+  size_t size() const
+  {
+    return params.size();
+  }
+
+  // Memory for 'n' bytes of data of parameter 'name', which replace its
+  // current value: that value's buffer if it is large enough, else new arena
+  // memory (nullptr if allocation fails)
+  uint8_t *storage(
+      AGXBlockPool &pool, uint32_t name, size_t n, size_t &capacity)
+  {
+    for (const auto &p : params) {
+      if (p.name == name && !p.data.appMemory && p.data.byteCapacity >= n) {
+        capacity = p.data.byteCapacity;
+        return p.data.bytes;
+      }
+    }
+    capacity = n;
+    return arena.allocate(pool, n);
+  }
+};
+
+// Staged bytes up to 'stagedEnd', followed by 'size' bytes of payload kept
+// where they are
+struct AGXSegment
+{
+  size_t stagedEnd{0};
+  const uint8_t *data{nullptr};
+  size_t size{0};
+};
+
+// Default size of the write-behind buffer of file outputs
+static const size_t AGX_DEFAULT_WRITE_BUFFER = size_t(1) << 20;
+
+// Output file which tracks the current byte offset (for the TOC). Writes are
+// collected in 'buffer' and go out in one gathered write together with the
+// first payload that doesn't fit. With 'staging' set, bytes are collected in
+// memory instead and payloads are only referenced in 'segments', to be written
+// out later at offset 'pos'. With 'direct' set, flushes go to the direct I/O
+// writer and 'f' is unused.
+struct AGXOutput
+{
+  std::FILE *f{nullptr};
+  AGXDirectWriter *direct{nullptr};
+  AGXExporterStats *stats{nullptr}; // the exporter's, for file outputs
+  const AGXTraceHooks *trace{nullptr};
+  uint64_t pos{0};
+  std::vector<uint8_t> buffer;
+  size_t bufferSize{AGX_DEFAULT_WRITE_BUFFER};
+  std::vector<uint8_t> *staging{nullptr};
+  std::vector<AGXSegment> *segments{nullptr};
+};
+
+// Location of a record or time step block in the file
+struct AGXTocEntry
+{
+  uint64_t offset{0};
+  uint64_t size{0};
+};
+
+// Exporter settings which affect how files are written
+struct AGXWriteOptions
+{
+  AGXCodec codec{AGX_CODEC_NONE};
+  int codecLevel{0};
+  bool deltaEncoding{false};
+  uint32_t keyframeInterval{0};
+  bool deduplicate{true};
+  bool promoteConstants{false};
+  uint32_t writeThreads{1}; // agxWrite() worker threads
+  size_t writeBufferSize{AGX_DEFAULT_WRITE_BUFFER};
+  uint64_t chunkBytes{0}; // arrays above this size are chunked, 0 = never
+  uint32_t payloadAlignment{0}; // array payload file offsets, 0 = any
+  AGXIOBackend ioBackend{AGX_IO_STDIO};
+  std::vector<uint8_t> quantization; // AGXQuantization by name id
+};
+
+// Largest agxSetPayloadAlignment() value
+static const uint32_t AGX_MAX_PAYLOAD_ALIGNMENT = uint32_t(1) << 20;
+
+// 128-bit content hash of an array payload plus its size
+struct AGXContentKey
+{
+  uint64_t h0{0};
+  uint64_t h1{0};
+  uint64_t size{0};
+
+  bool operator==(const AGXContentKey &o) const
+  {
+    return h0 == o.h0 && h1 == o.h1 && size == o.size;
+  }
+};
+
+struct AGXContentKeyHash
+{
+  size_t operator()(const AGXContentKey &k) const
+  {
+    return static_cast<size_t>(k.h0);
+  }
+};
+
+// First record written with a given content; 'live' points at its data while
+// the exporter still holds it (always for agxWrite(), only until the record's
+// section is released when streaming)
+struct AGXDedupEntry
+{
+  uint64_t recordOffset{0};
+  const ParamData *live{nullptr};
+};
+
+// Quantized form of an array (agxSetArrayQuantization): the record fields
+// restoring it, and the stored array of quantized elements ('bytes', once
+// quantizePayload() has run)
+struct AGXQuantized
+{
+  uint8_t mode{AGX_QUANTIZE_NONE};
+  ANARIDataType elementType{ANARI_UNKNOWN}; // of the original array
+  uint8_t boundsCount{0}; // components with bounds (AGX_QUANTIZE_BOUNDS16)
+  float boundsMin[4]{};
+  float boundsMax[4]{};
+  ParamData stored; // non-owning view of 'bytes'
+  std::vector<uint8_t> bytes;
+};
+
+// State of a file being written, either all at once by agxWrite() or
+// incrementally by a streaming exporter
+struct AGXFileWriter
+{
+  AGXOutput out;
+  std::unique_ptr<AGXDirectWriter> direct; // AGX_IO_DIRECT output
+  const AGXWriteOptions *options{nullptr};
+  const AGXNameTable *names{nullptr};
+  std::vector<uint8_t> scratch; // compressed payload staging
+  std::vector<uint8_t> delta; // delta payload staging
+  AGXQuantized quantized; // quantized payload staging
+
+  // Array record offsets of the last written time step (delta bases) by name
+  // id, 0 where there is none (offset 0 is the file header)
+  std::vector<uint64_t> prevRecordOffsets;
+  std::vector<uint64_t> curRecordOffsets;
+
+  // Content of all arrays written so far (deduplication)
+  std::unordered_map<AGXContentKey, AGXDedupEntry, AGXContentKeyHash> dedup;
+  std::vector<AGXContentKey> dedupLive; // entries with 'live' set
+
+  // Time step parameters written as constants, by name id (agxWrite() only)
+  std::vector<uint8_t> promoted;
+  uint32_t promotedCount{0};
+  bool ok{true};
+  bool headerWritten{false};
+  uint32_t headerTimeSteps{0}; // value written in the header, patched at end
+  uint32_t headerVersion{0}; // likewise (appended files may be older)
+  uint64_t timeStepsStart{0};
+  std::vector<AGXTocEntry> constantToc;
+  std::vector<AGXTocEntry> timeStepToc;
+  std::vector<double> timeStepTimes; // one per timeStepToc entry
 };
 
 struct AGXExporter_t
 {
   std::string subtype; // optional
   uint32_t timeSteps{0};
-  std::unordered_map<std::string, ParamData> constants;
-  std::vector<std::unordered_map<std::string, ParamData>>
-      perTimeStep; // size = timeSteps
+  AGXWriteOptions options;
+  AGXBlockPool pool; // section arena blocks, outlives all sections
+  AGXNameTable names; // all parameter names, shared by all sections
+  ParamList constants;
+  std::vector<ParamList> perTimeStep; // size = timeSteps
+  std::vector<double> stepTimes; // size = timeSteps
+
+  // Streaming export: time steps below 'nextStep' are already written and
+  // their data released
+  bool streaming{false};
+  AGXFileWriter stream;
+  std::vector<uint8_t> stepEnded;
+  uint32_t nextStep{0};
+  bool droppedEdits{false};
+  ParamList streamPrevStep; // last written step, kept as delta base
+
+  // Instrumentation (agxExporterGetStats / agxExporterSetTraceHooks)
+  AGXExporterStats stats{};
+  AGXTraceHooks trace;
 };
 
 static inline uint32_t clampToValidIndex(uint32_t idx, uint32_t max)
@@ -164,97 +1044,1759 @@ const char *agxDataTypeToString(ANARIDataType t)
   return anari::toString(t);
 }
 
-static void copyBytes(ParamData &dst, const void *src, size_t nbytes)
+// Copy 'nbytes' bytes from 'src' (zeros if null) into memory of the section
+// 'dst' is set in, under 'name'
+static bool copyBytes(AGXExporter_t *e,
+    ParamList &section,
+    uint32_t name,
+    ParamData &dst,
+    const void *src,
+    size_t nbytes)
 {
-  dst.bytes.resize(nbytes);
-  if (src && nbytes > 0)
-    std::memcpy(dst.bytes.data(), src, nbytes);
+  if (nbytes == 0)
+    return true;
+  AGXPhaseTimer t(&e->trace, "agx.write.copy", &e->stats.copySeconds);
+  e->stats.bytesCopied += nbytes;
+  dst.bytes = section.storage(e->pool, name, nbytes, dst.byteCapacity);
+  if (!dst.bytes)
+    return false;
+  dst.byteCount = nbytes;
+  if (src)
+    std::memcpy(dst.bytes, src, nbytes);
+  else
+    std::memset(dst.bytes, 0, nbytes);
+  return true;
 }
 
-// Write helpers
-template <typename T>
-static bool writePOD(std::FILE *f, const T &v)
+static void shareBytes(ParamData &dst,
+    const void *appMemory,
+    size_t nbytes,
+    AGXMemoryDeleter deleter,
+    const void *userData)
 {
-  return std::fwrite(&v, sizeof(T), 1, f) == 1;
+  dst.appMemory = appMemory;
+  dst.appBytes = appMemory ? nbytes : 0;
+  dst.deleter = deleter;
+  dst.deleterUserData = userData;
 }
 
-static bool writeBytes(std::FILE *f, const void *data, size_t n)
+// Write helpers
+#ifndef _WIN32
+#ifndef IOV_MAX
+#define IOV_MAX 16
+#endif
+
+// Write all of 'iov' with writev(), or with pwritev() at 'offset' if given
+static bool writeGathered(
+    int fd, struct iovec *iov, int count, const uint64_t *offset = nullptr)
 {
-  if (n == 0)
-    return true;
-  return std::fwrite(data, 1, n, f) == n;
+  uint64_t at = offset ? *offset : 0;
+  while (count > 0) {
+    const int n = std::min(count, static_cast<int>(IOV_MAX));
+    const ssize_t written = offset
+        ? ::pwritev(fd, iov, n, static_cast<off_t>(at))
+        : ::writev(fd, iov, n);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written < 0)
+      return false;
+    at += static_cast<uint64_t>(written);
+    size_t left = static_cast<size_t>(written);
+    while (count > 0 && left >= iov->iov_len) {
+      left -= iov->iov_len;
+      ++iov;
+      --count;
+    }
+    if (count == 0)
+      break;
+    if (written == 0)
+      return false;
+    iov->iov_base = static_cast<char *>(iov->iov_base) + left;
+    iov->iov_len -= left;
+  }
+  return true;
 }
+#endif
 
-static bool writeString(std::FILE *f, const std::string &s)
+// Write the buffered bytes, followed by 'n' bytes at 'data', to the file
+static bool flushOutput(AGXOutput &f, const void *data = nullptr, size_t n = 0)
 {
-  uint32_t len = static_cast<uint32_t>(s.size());
-  return writePOD(f, len) && writeBytes(f, s.data(), len);
+  if (f.buffer.empty() && n == 0)
+    return true;
+  AGXPhaseTimer t(
+      f.trace, "agx.write.output", f.stats ? &f.stats->outputSeconds : nullptr);
+  if (f.stats)
+    f.stats->bytesWritten += f.buffer.size() + n;
+  if (f.direct) {
+    const bool ok = f.direct->write(f.buffer.data(), f.buffer.size())
+        && f.direct->write(data, n);
+    f.buffer.clear();
+    return ok;
+  }
+#ifndef _WIN32
+  struct iovec iov[2];
+  iov[0].iov_base = f.buffer.data();
+  iov[0].iov_len = f.buffer.size();
+  iov[1].iov_base = const_cast<void *>(data);
+  iov[1].iov_len = n;
+  const bool ok = writeGathered(fileno(f.f), iov, 2);
+#else
+  const bool ok = (f.buffer.empty()
+                      || std::fwrite(f.buffer.data(), 1, f.buffer.size(), f.f)
+                          == f.buffer.size())
+      && (n == 0 || std::fwrite(data, 1, n, f.f) == n);
+#endif
+  f.buffer.clear();
+  return ok;
 }
 
-static bool writeParamRecord(
-    std::FILE *f, const std::string &name, const ParamData &p)
+static bool writeBytes(AGXOutput &f, const void *data, size_t n)
 {
-  uint8_t isArray = p.isArray ? 1 : 0;
-  if (!writeString(f, name))
-    return false;
-  if (!writePOD(f, isArray))
+  if (n == 0)
+    return true;
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+  if (f.staging)
+    f.staging->insert(f.staging->end(), p, p + n);
+  else if (f.buffer.size() + n <= f.bufferSize)
+    f.buffer.insert(f.buffer.end(), p, p + n);
+  else if (!flushOutput(f, data, n))
     return false;
-
-  if (!p.isArray) {
-    uint32_t type = static_cast<uint32_t>(p.type);
-    uint32_t nbytes = static_cast<uint32_t>(p.bytes.size());
-    if (!writePOD(f, type))
-      return false;
-    if (!writePOD(f, nbytes))
-      return false;
-    if (!writeBytes(f, p.bytes.data(), nbytes))
-      return false;
-  } else {
-    uint32_t elementType = static_cast<uint32_t>(p.elementType);
-    uint64_t elementCount = p.elementCount;
-    uint64_t dataBytes = static_cast<uint64_t>(p.bytes.size());
-    if (!writePOD(f, elementType))
-      return false;
-    if (!writePOD(f, elementCount))
-      return false;
-    if (!writePOD(f, dataBytes))
-      return false;
-    if (!writeBytes(f, p.bytes.data(), static_cast<size_t>(dataBytes)))
-      return false;
-  }
-
+  f.pos += n;
   return true;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// Public API definitions /////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////
-
-extern "C" {
-
-AGXExporter agxNewExporter()
+// Like writeBytes(), but staged outputs reference 'data' instead of copying
+// it, so it has to stay valid until the staged bytes are written out
+static bool writePayload(AGXOutput &f, const uint8_t *data, size_t n)
 {
-  return new (std::nothrow) AGXExporter_t{};
+  if (!f.staging || n == 0)
+    return writeBytes(f, data, n);
+  AGXSegment s;
+  s.stagedEnd = f.staging->size();
+  s.data = data;
+  s.size = n;
+  f.segments->push_back(s);
+  f.pos += n;
+  return true;
 }
 
-void agxReleaseExporter(AGXExporter exporter)
+template <typename T>
+static bool writePOD(AGXOutput &f, const T &v)
 {
-  delete exporter;
+  return writeBytes(f, &v, sizeof(T));
 }
 
-void agxSetObjectSubtype(AGXExporter exporter, const char *subtype)
+static bool writeString(AGXOutput &f, const std::string &s)
 {
-  if (!exporter)
-    return;
-  exporter->subtype = subtype ? std::string(subtype) : std::string{};
+  uint32_t len = static_cast<uint32_t>(s.size());
+  return writePOD(f, len) && writeBytes(f, s.data(), len);
 }
 
-void agxSetTimeStepCount(AGXExporter exporter, uint32_t count)
+static bool writeTocEntries(AGXOutput &f, const std::vector<AGXTocEntry> &v)
 {
-  if (!exporter)
-    return;
-  exporter->timeSteps = count;
-  exporter->perTimeStep.resize(count);
+  uint32_t count = static_cast<uint32_t>(v.size());
+  bool ok = writePOD(f, count);
+  for (size_t i = 0; ok && i < v.size(); ++i)
+    ok = writePOD(f, v[i].offset) && writePOD(f, v[i].size);
+  return ok;
+}
+
+// Table of contents + footer, written after the last time step
+static bool writeToc(AGXOutput &f,
+    uint64_t timeStepsStart,
+    const std::vector<AGXTocEntry> &constants,
+    const std::vector<AGXTocEntry> &timeSteps,
+    const std::vector<double> &times)
+{
+  const char tocMagic[4] = {'A', 'G', 'X', 'T'};
+  const char footerMagic[4] = {'A', 'G', 'X', 'F'};
+  const uint64_t tocOffset = f.pos;
+
+  bool ok = writeBytes(f, tocMagic, sizeof(tocMagic));
+  ok = ok && writePOD(f, timeStepsStart);
+  ok = ok && writeTocEntries(f, constants);
+  ok = ok && writeTocEntries(f, timeSteps);
+  for (size_t i = 0; ok && i < times.size(); ++i)
+    ok = writePOD(f, times[i]);
+  ok = ok && writePOD(f, tocOffset);
+  ok = ok && writeBytes(f, footerMagic, sizeof(footerMagic));
+  return ok;
+}
+
+// Compress 'n' bytes into 'dst'; returns false if the codec is unavailable or
+// the result would not be smaller than the input
+static bool compressPayload(AGXCodec codec,
+    int level,
+    const uint8_t *src,
+    size_t n,
+    std::vector<uint8_t> &dst,
+    size_t at = 0)
+{
+  (void)level;
+  (void)src;
+  (void)dst;
+  (void)at;
+  if (n == 0)
+    return false;
+  switch (codec) {
+#ifdef AGX_WITH_LZ4
+  case AGX_CODEC_LZ4: {
+    if (n > static_cast<size_t>(LZ4_MAX_INPUT_SIZE))
+      return false;
+    const int srcSize = static_cast<int>(n);
+    const int cap = LZ4_compressBound(srcSize);
+    dst.resize(at + static_cast<size_t>(cap));
+    char *out = reinterpret_cast<char *>(dst.data() + at);
+    const char *in = reinterpret_cast<const char *>(src);
+    const int written = level > 1
+        ? LZ4_compress_HC(in, out, srcSize, cap, level)
+        : LZ4_compress_default(in, out, srcSize, cap);
+    if (written <= 0 || static_cast<size_t>(written) >= n) {
+      dst.resize(at);
+      return false;
+    }
+    dst.resize(at + static_cast<size_t>(written));
+    return true;
+  }
+#endif
+#ifdef AGX_WITH_ZSTD
+  case AGX_CODEC_ZSTD: {
+    const size_t cap = ZSTD_compressBound(n);
+    dst.resize(at + cap);
+    const size_t written = ZSTD_compress(dst.data() + at, cap, src, n, level);
+    if (ZSTD_isError(written) || written >= n) {
+      dst.resize(at);
+      return false;
+    }
+    dst.resize(at + written);
+    return true;
+  }
+#endif
+  default:
+    return false;
+  }
+}
+
+// MurmurHash3 (x64, 128-bit) of 'n' bytes
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64(uint64_t k)
+{
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdull;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ull;
+  k ^= k >> 33;
+  return k;
+}
+
+static AGXContentKey hashPayload(const uint8_t *data, size_t n)
+{
+  const uint64_t c1 = 0x87c37b91114253d5ull;
+  const uint64_t c2 = 0x4cf5ad432745937full;
+  uint64_t h1 = 0;
+  uint64_t h2 = 0;
+
+  const size_t blocks = n / 16;
+  for (size_t i = 0; i < blocks; ++i) {
+    uint64_t k1, k2;
+    std::memcpy(&k1, data + i * 16, 8);
+    std::memcpy(&k2, data + i * 16 + 8, 8);
+    k1 *= c1;
+    k1 = rotl64(k1, 31);
+    k1 *= c2;
+    h1 ^= k1;
+    h1 = rotl64(h1, 27);
+    h1 += h2;
+    h1 = h1 * 5 + 0x52dce729;
+    k2 *= c2;
+    k2 = rotl64(k2, 33);
+    k2 *= c1;
+    h2 ^= k2;
+    h2 = rotl64(h2, 31);
+    h2 += h1;
+    h2 = h2 * 5 + 0x38495ab5;
+  }
+
+  const uint8_t *tail = data + blocks * 16;
+  const size_t rem = n & 15;
+  uint64_t k1 = 0;
+  uint64_t k2 = 0;
+  for (size_t i = rem; i > 8; --i)
+    k2 = (k2 << 8) | tail[i - 1];
+  for (size_t i = std::min<size_t>(rem, 8); i > 0; --i)
+    k1 = (k1 << 8) | tail[i - 1];
+  if (rem > 8) {
+    k2 *= c2;
+    k2 = rotl64(k2, 33);
+    k2 *= c1;
+    h2 ^= k2;
+  }
+  if (rem > 0) {
+    k1 *= c1;
+    k1 = rotl64(k1, 31);
+    k1 *= c2;
+    h1 ^= k1;
+  }
+
+  h1 ^= static_cast<uint64_t>(n);
+  h2 ^= static_cast<uint64_t>(n);
+  h1 += h2;
+  h2 += h1;
+  h1 = fmix64(h1);
+  h2 = fmix64(h2);
+  h1 += h2;
+  h2 += h1;
+
+  AGXContentKey k;
+  k.h0 = h1;
+  k.h1 = h2;
+  k.size = static_cast<uint64_t>(n);
+  return k;
+}
+
+// Element type arrays of 'type' are stored as with quantization 'mode', or
+// ANARI_UNKNOWN if 'mode' doesn't apply to them. Relies on ANARI's enum
+// layout, where the VEC2..VEC4 forms follow each scalar type.
+static ANARIDataType quantizedElementType(uint8_t mode, ANARIDataType type)
+{
+  if (type < ANARI_FLOAT32 || type > ANARI_FLOAT32_VEC4)
+    return ANARI_UNKNOWN;
+  const int vec = type - ANARI_FLOAT32;
+  switch (mode) {
+  case AGX_QUANTIZE_FLOAT16:
+    return static_cast<ANARIDataType>(ANARI_FLOAT16 + vec);
+  case AGX_QUANTIZE_OCT16:
+    return type == ANARI_FLOAT32_VEC3 ? ANARI_FIXED16_VEC2 : ANARI_UNKNOWN;
+  case AGX_QUANTIZE_BOUNDS16:
+    return static_cast<ANARIDataType>(ANARI_UFIXED16 + vec);
+  default:
+    return ANARI_UNKNOWN;
+  }
+}
+
+// The quantization array 'p' named 'name' is stored with (AGX_QUANTIZE_NONE
+// if none is set or it doesn't apply)
+static uint8_t quantizationOf(
+    const AGXWriteOptions &opts, uint32_t name, const ParamData &p)
+{
+  if (!p.isArray || p.elementCount == 0 || name >= opts.quantization.size())
+    return AGX_QUANTIZE_NONE;
+  const uint8_t mode = opts.quantization[name];
+  if (quantizedElementType(mode, p.elementType) == ANARI_UNKNOWN
+      || p.size() != p.elementCount * agxSizeOf(p.elementType))
+    return AGX_QUANTIZE_NONE;
+  return mode;
+}
+
+// Round to the nearest half float, ties to even
+static uint16_t floatToHalf(float value)
+{
+  uint32_t x = 0;
+  std::memcpy(&x, &value, sizeof(x));
+  const uint16_t sign = static_cast<uint16_t>((x >> 16) & 0x8000u);
+  x &= 0x7fffffffu;
+  if (x > 0x7f800000u)
+    return sign | 0x7e00u; // NaN
+  if (x >= 0x477ff000u)
+    return sign | 0x7c00u; // rounds to infinity (>= 65520)
+  if (x < 0x38800000u) {
+    // Subnormal: multiples of 2^-24, exact in float
+    const float a = std::fabs(value) * 16777216.0f;
+    return sign | static_cast<uint16_t>(std::nearbyint(a));
+  }
+  x -= 0x38000000u; // rebias the exponent from 127 to 15
+  x += 0x0fffu + ((x >> 13) & 1u);
+  return sign | static_cast<uint16_t>(x >> 13);
+}
+
+static int16_t toSnorm16(float v)
+{
+  v = std::min(1.0f, std::max(-1.0f, v));
+  return static_cast<int16_t>(std::lround(v * 32767.0f));
+}
+
+// Fill in the record fields of array 'p' stored with 'mode' (computing the
+// bounds for AGX_QUANTIZE_BOUNDS16), leaving the payload to quantizePayload()
+static void describeQuantized(
+    const ParamData &p, uint8_t mode, AGXQuantized &q)
+{
+  const ANARIDataType storedType = quantizedElementType(mode, p.elementType);
+  q.mode = mode;
+  q.elementType = p.elementType;
+  q.bytes.clear();
+  q.stored.isArray = true;
+  q.stored.elementType = storedType;
+  q.stored.elementCount = p.elementCount;
+  q.stored.dimensions = p.dimensions;
+  std::memcpy(q.stored.numItems, p.numItems, sizeof(p.numItems));
+  q.stored.bytes = nullptr;
+  q.stored.byteCount =
+      static_cast<size_t>(p.elementCount * agxSizeOf(storedType));
+  q.boundsCount = 0;
+  if (mode != AGX_QUANTIZE_BOUNDS16)
+    return;
+
+  const size_t components = anari::componentsOf(p.elementType);
+  const uint8_t *src = p.data();
+  q.boundsCount = static_cast<uint8_t>(components);
+  for (size_t c = 0; c < components; ++c) {
+    float lo = INFINITY;
+    float hi = -INFINITY;
+    for (uint64_t i = 0; i < p.elementCount; ++i) {
+      float v;
+      std::memcpy(&v, src + (i * components + c) * sizeof(float), sizeof(v));
+      if (std::isfinite(v)) {
+        lo = std::min(lo, v);
+        hi = std::max(hi, v);
+      }
+    }
+    q.boundsMin[c] = lo <= hi ? lo : 0.0f;
+    q.boundsMax[c] = lo <= hi ? hi : 0.0f;
+  }
+}
+
+// Quantize the payload of array 'p' as described by 'q' into q.bytes
+static void quantizePayload(const ParamData &p, AGXQuantized &q)
+{
+  const size_t components = anari::componentsOf(p.elementType);
+  const size_t n = static_cast<size_t>(p.elementCount) * components;
+  const uint8_t *src = p.data();
+  q.bytes.resize(q.stored.byteCount);
+  uint8_t *dst = q.bytes.data();
+  auto load = [&](size_t i) {
+    float v;
+    std::memcpy(&v, src + i * sizeof(float), sizeof(v));
+    return v;
+  };
+
+  switch (q.mode) {
+  case AGX_QUANTIZE_FLOAT16:
+    for (size_t i = 0; i < n; ++i) {
+      const uint16_t h = floatToHalf(load(i));
+      std::memcpy(dst + i * sizeof(h), &h, sizeof(h));
+    }
+    break;
+  case AGX_QUANTIZE_OCT16:
+    // Project onto the octahedron |x| + |y| + |z| = 1 and fold the lower half
+    // over the upper one; degenerate vectors become +z
+    for (size_t i = 0; i < n; i += 3) {
+      float x = load(i);
+      float y = load(i + 1);
+      const float z = load(i + 2);
+      const float l1 = std::fabs(x) + std::fabs(y) + std::fabs(z);
+      if (!(l1 > 0.0f) || !std::isfinite(l1)) {
+        x = y = 0.0f;
+      } else {
+        x /= l1;
+        y /= l1;
+        if (z < 0.0f) {
+          const float fx = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+          const float fy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+          x = fx;
+          y = fy;
+        }
+      }
+      const int16_t e[2] = {toSnorm16(x), toSnorm16(y)};
+      std::memcpy(dst + (i / 3) * sizeof(e), e, sizeof(e));
+    }
+    break;
+  case AGX_QUANTIZE_BOUNDS16: {
+    double scale[4] = {};
+    for (size_t c = 0; c < components; ++c) {
+      const double range = double(q.boundsMax[c]) - double(q.boundsMin[c]);
+      scale[c] = range > 0.0 ? 65535.0 / range : 0.0;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      const size_t c = i % components;
+      double t = (double(load(i)) - double(q.boundsMin[c])) * scale[c];
+      t = t > 0.0 ? std::min(t, 65535.0) : 0.0; // also clamps NaN
+      const uint16_t u = static_cast<uint16_t>(t + 0.5);
+      std::memcpy(dst + i * sizeof(u), &u, sizeof(u));
+    }
+    break;
+  }
+  default:
+    break;
+  }
+  q.stored.bytes = q.bytes.data();
+}
+
+// Arrays smaller than this aren't worth a reference
+static const size_t AGX_DEDUP_MIN_BYTES = 16;
+
+static bool isDedupCandidate(const AGXWriteOptions &opts, const ParamData &p)
+{
+  return opts.deduplicate && p.isArray && p.size() >= AGX_DEDUP_MIN_BYTES;
+}
+
+// Content key of array 'p' stored with quantization 'mode'. Equal keys must
+// mean equal stored payloads, so quantized arrays only match arrays of the same
+// element type quantized the same way.
+static AGXContentKey contentKey(const ParamData &p, uint8_t mode)
+{
+  AGXContentKey key = hashPayload(p.data(), p.size());
+  if (mode != AGX_QUANTIZE_NONE)
+    key.h1 ^= fmix64((uint64_t(mode) << 32) | uint32_t(p.elementType));
+  return key;
+}
+
+// Look up array 'p' with content hash 'key' among the arrays written so far.
+// Sets 'duplicate' and returns the entry of the first record holding the same
+// bytes, otherwise registers 'p' as a first occurrence and returns its new
+// entry (whose recordOffset the caller fills in). Returns nullptr for hash
+// collisions, which are stored in full.
+static AGXDedupEntry *matchContent(AGXFileWriter &w,
+    const ParamData &p,
+    const AGXContentKey &key,
+    bool &duplicate)
+{
+  duplicate = false;
+  auto it = w.dedup.find(key);
+  if (it == w.dedup.end()) {
+    AGXDedupEntry entry;
+    entry.live = &p;
+    w.dedupLive.push_back(key);
+    return &w.dedup.emplace(key, entry).first->second;
+  }
+
+  // With both arrays at hand, confirm the match byte by byte; once the first
+  // one is released, the 128-bit hash has to do
+  const ParamData *first = it->second.live;
+  if (first && std::memcmp(first->data(), p.data(), p.size()) != 0)
+    return nullptr;
+  duplicate = true;
+  return &it->second;
+}
+
+// Returns true with the offset of the first record holding the same bytes as
+// array 'p' (stored with quantization 'mode'), otherwise registers 'p' as
+// written at 'recordOffset'
+static bool findDuplicate(AGXFileWriter &w,
+    const ParamData &p,
+    uint8_t mode,
+    uint64_t recordOffset,
+    uint64_t &refOffset)
+{
+  if (!isDedupCandidate(*w.options, p))
+    return false;
+
+  bool duplicate = false;
+  AGXDedupEntry *entry = matchContent(w, p, contentKey(p, mode), duplicate);
+  if (duplicate)
+    refOffset = entry->recordOffset;
+  else if (entry)
+    entry->recordOffset = recordOffset;
+  return duplicate;
+}
+
+// Forget the data pointers of dedup entries, before the exporter releases the
+// data they point to
+static void releaseDedupData(AGXFileWriter &w)
+{
+  for (const auto &key : w.dedupLive) {
+    auto it = w.dedup.find(key);
+    if (it != w.dedup.end())
+      it->second.live = nullptr;
+  }
+  w.dedupLive.clear();
+}
+
+// Delta base of an array record: the same-named array of the previous time
+// step and where its record starts in the file
+struct AGXDeltaBase
+{
+  const ParamData *data{nullptr};
+  uint64_t recordOffset{0};
+};
+
+// Lane width of integer element types, which are delta-encoded by wrapping
+// subtraction; 0 for everything else (XOR). Relies on ANARI's enum layout,
+// where all integer and fixed point types lie in [ANARI_INT8, ANARI_FLOAT16).
+static uint8_t deltaLaneBytes(ANARIDataType t)
+{
+  if (t < ANARI_INT8 || t >= ANARI_FLOAT16)
+    return 0;
+  const int components = anari::componentsOf(t);
+  const size_t lane = components > 0 ? agxSizeOf(t) / components : 0;
+  return lane == 1 || lane == 2 || lane == 4 || lane == 8
+      ? static_cast<uint8_t>(lane)
+      : 0;
+}
+
+template <typename T>
+static void subtractLanes(
+    uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t n)
+{
+  for (size_t i = 0; i + sizeof(T) <= n; i += sizeof(T)) {
+    T x, y;
+    std::memcpy(&x, a + i, sizeof(T));
+    std::memcpy(&y, b + i, sizeof(T));
+    const T d = static_cast<T>(x - y);
+    std::memcpy(dst + i, &d, sizeof(T));
+  }
+}
+
+// Compute the delta of 'p' against 'base' (same size) into 'out'; returns
+// the AGX_DELTA_* mode used
+static uint8_t computeDelta(const ParamData &p,
+    const ParamData &base,
+    std::vector<uint8_t> &out,
+    uint8_t &laneBytes)
+{
+  const size_t n = p.size();
+  const uint8_t *a = p.data();
+  const uint8_t *b = base.data();
+  laneBytes = 0;
+  out.clear();
+  if (std::memcmp(a, b, n) == 0)
+    return AGX_DELTA_COPY;
+
+  out.resize(n);
+  laneBytes = deltaLaneBytes(p.elementType);
+  switch (laneBytes) {
+  case 1:
+    subtractLanes<uint8_t>(out.data(), a, b, n);
+    return AGX_DELTA_ADD;
+  case 2:
+    subtractLanes<uint16_t>(out.data(), a, b, n);
+    return AGX_DELTA_ADD;
+  case 4:
+    subtractLanes<uint32_t>(out.data(), a, b, n);
+    return AGX_DELTA_ADD;
+  case 8:
+    subtractLanes<uint64_t>(out.data(), a, b, n);
+    return AGX_DELTA_ADD;
+  default:
+    for (size_t i = 0; i < n; ++i)
+      out[i] = a[i] ^ b[i];
+    return AGX_DELTA_XOR;
+  }
+}
+
+// How an array record's payload is stored
+struct AGXRecordEncoding
+{
+  bool isRef{false};
+  uint64_t refOffset{0};
+  const ParamData *base{nullptr}; // delta base
+  uint64_t baseOffset{0};
+  uint8_t deltaMode{0};
+  uint8_t laneBytes{0};
+  bool encoded{false};
+  bool chunked{false};
+  uint64_t chunkElements{0};
+  std::vector<uint64_t> chunkBytes; // stored size of each chunk
+  const AGXQuantized *quantized{nullptr}; // the record's stored array, if set
+  const uint8_t *payload{nullptr};
+  size_t payloadBytes{0};
+};
+
+// Whether array 'p', stored in full, is split into chunks
+static bool isChunked(const AGXWriteOptions &opts,
+    const ParamData &p,
+    const AGXRecordEncoding &enc)
+{
+  return p.isArray && !enc.isRef && !enc.base && opts.chunkBytes > 0
+      && p.size() > opts.chunkBytes && p.elementCount > 1
+      && p.size() % p.elementCount == 0;
+}
+
+// Split 'p' into chunks of about opts.chunkBytes, compressing each on its own
+// into 'compressed' (chunks which don't get smaller are copied raw). The
+// payload is 'p' itself if no chunk was compressed.
+static void encodeChunks(const AGXWriteOptions &opts,
+    const ParamData &p,
+    AGXRecordEncoding &enc,
+    std::vector<uint8_t> &compressed)
+{
+  const size_t elementBytes = p.size() / p.elementCount;
+  enc.chunked = true;
+  enc.chunkElements = std::max<uint64_t>(1, opts.chunkBytes / elementBytes);
+  const size_t chunkSize =
+      static_cast<size_t>(enc.chunkElements) * elementBytes;
+  const size_t chunkCount = (p.size() + chunkSize - 1) / chunkSize;
+  enc.chunkBytes.clear();
+  enc.chunkBytes.reserve(chunkCount);
+
+  bool anyCompressed = false;
+  compressed.clear();
+  for (size_t c = 0; c < chunkCount; ++c) {
+    const uint8_t *src = p.data() + c * chunkSize;
+    const size_t n = std::min(chunkSize, p.size() - c * chunkSize);
+    if (opts.codec == AGX_CODEC_NONE) {
+      enc.chunkBytes.push_back(n);
+      continue;
+    }
+    const size_t at = compressed.size();
+    if (compressPayload(opts.codec, opts.codecLevel, src, n, compressed, at))
+      anyCompressed = true;
+    else
+      compressed.insert(compressed.end(), src, src + n);
+    enc.chunkBytes.push_back(compressed.size() - at);
+  }
+  if (anyCompressed) {
+    enc.payload = compressed.data();
+    enc.payloadBytes = compressed.size();
+  }
+}
+
+// Compute the stored payload of 'p' given the reference/delta base choice in
+// 'enc': delta-encoded into 'delta' and/or compressed into 'compressed'
+static void encodeRecord(const AGXWriteOptions &opts,
+    const ParamData &p,
+    AGXRecordEncoding &enc,
+    std::vector<uint8_t> &delta,
+    std::vector<uint8_t> &compressed)
+{
+  enc.payload = p.data();
+  enc.payloadBytes = p.size();
+  enc.encoded = false;
+  enc.chunked = false;
+  if (!p.isArray || enc.isRef)
+    return;
+  if (isChunked(opts, p, enc)) {
+    encodeChunks(opts, p, enc, compressed);
+    return;
+  }
+
+  // Delta-encode against the previous time step's array
+  if (enc.base) {
+    enc.deltaMode = computeDelta(p, *enc.base, delta, enc.laneBytes);
+    enc.payload = delta.data();
+    enc.payloadBytes = delta.size();
+  }
+
+  // Try to compress array payloads
+  enc.encoded = opts.codec != AGX_CODEC_NONE
+      && compressPayload(opts.codec,
+          opts.codecLevel,
+          enc.payload,
+          enc.payloadBytes,
+          compressed);
+  if (enc.encoded) {
+    enc.payload = compressed.data();
+    enc.payloadBytes = compressed.size();
+  }
+}
+
+// Write a record with its payload stored as described by 'enc' ('p' is the
+// stored array of quantized records)
+static bool emitRecord(AGXOutput &f,
+    const std::string &name,
+    const ParamData &p,
+    const AGXRecordEncoding &enc,
+    const AGXWriteOptions &opts)
+{
+  const AGXCodec codec = opts.codec;
+  const bool aligned = p.isArray && !enc.isRef && enc.payloadBytes > 0
+      && opts.payloadAlignment > 1;
+  uint8_t flags = p.isArray ? AGX_RECORD_FLAG_ARRAY : 0;
+  if (enc.encoded)
+    flags |= AGX_RECORD_FLAG_ENCODED;
+  if (enc.base && !enc.isRef)
+    flags |= AGX_RECORD_FLAG_DELTA;
+  if (enc.isRef)
+    flags |= AGX_RECORD_FLAG_REF;
+  if (enc.chunked)
+    flags |= AGX_RECORD_FLAG_CHUNKED;
+  if (aligned)
+    flags |= AGX_RECORD_FLAG_ALIGNED;
+  if (enc.quantized)
+    flags |= AGX_RECORD_FLAG_QUANTIZED;
+  if (p.isArray && p.dimensions > 1)
+    flags |= AGX_RECORD_FLAG_SHAPED;
+  if (f.stats) {
+    const bool compressed =
+        enc.encoded || (enc.chunked && enc.payloadBytes < p.size());
+    AGXExporterStats &s = *f.stats;
+    s.recordsWritten++;
+    s.arraysDeduplicated += enc.isRef ? 1 : 0;
+    s.arraysDeltaEncoded += (flags & AGX_RECORD_FLAG_DELTA) ? 1 : 0;
+    s.arraysCompressed += compressed ? 1 : 0;
+    s.arraysQuantized += enc.quantized ? 1 : 0;
+  }
+  if (!writeString(f, name))
+    return false;
+  if (!writePOD(f, flags))
+    return false;
+
+  if (!p.isArray) {
+    uint32_t type = static_cast<uint32_t>(p.type);
+    uint32_t nbytes = static_cast<uint32_t>(p.size());
+    if (!writePOD(f, type))
+      return false;
+    if (!writePOD(f, nbytes))
+      return false;
+    if (!writeBytes(f, p.data(), nbytes))
+      return false;
+  } else {
+    uint32_t elementType = static_cast<uint32_t>(
+        enc.quantized ? enc.quantized->elementType : p.elementType);
+    uint64_t elementCount = p.elementCount;
+    uint64_t dataBytes = static_cast<uint64_t>(p.size());
+    if (!writePOD(f, elementType))
+      return false;
+    if (!writePOD(f, elementCount))
+      return false;
+    if (!writePOD(f, dataBytes))
+      return false;
+    if (enc.encoded) {
+      uint8_t c = static_cast<uint8_t>(codec);
+      uint64_t storedBytes = static_cast<uint64_t>(enc.payloadBytes);
+      if (!writePOD(f, c))
+        return false;
+      if (!writePOD(f, storedBytes))
+        return false;
+    }
+    if (flags & AGX_RECORD_FLAG_DELTA) {
+      if (!writePOD(f, enc.deltaMode))
+        return false;
+      if (!writePOD(f, enc.laneBytes))
+        return false;
+      if (!writePOD(f, enc.baseOffset))
+        return false;
+    }
+    if (enc.isRef && !writePOD(f, enc.refOffset))
+      return false;
+    if (enc.chunked) {
+      uint8_t c = static_cast<uint8_t>(codec);
+      uint64_t storedBytes = static_cast<uint64_t>(enc.payloadBytes);
+      if (!writePOD(f, c))
+        return false;
+      if (!writePOD(f, enc.chunkElements))
+        return false;
+      if (!writePOD(f, storedBytes))
+        return false;
+      if (!writeBytes(f,
+              enc.chunkBytes.data(),
+              enc.chunkBytes.size() * sizeof(uint64_t)))
+        return false;
+    }
+    if (enc.quantized) {
+      const AGXQuantized &q = *enc.quantized;
+      const size_t boundsBytes = q.boundsCount * sizeof(float);
+      if (!writePOD(f, q.mode) || !writePOD(f, q.boundsCount))
+        return false;
+      if (!writeBytes(f, q.boundsMin, boundsBytes)
+          || !writeBytes(f, q.boundsMax, boundsBytes))
+        return false;
+    }
+    if (flags & AGX_RECORD_FLAG_SHAPED) {
+      if (!writePOD(f, p.dimensions)
+          || !writeBytes(f, p.numItems, p.dimensions * sizeof(uint64_t)))
+        return false;
+    }
+    if (aligned) {
+      const uint64_t align = opts.payloadAlignment;
+      const uint64_t payloadStart = f.pos + sizeof(uint32_t);
+      uint32_t padBytes =
+          static_cast<uint32_t>((align - payloadStart % align) % align);
+      if (!writePOD(f, padBytes))
+        return false;
+      static const uint8_t zeros[256] = {};
+      while (padBytes > 0) {
+        const uint32_t n = std::min<uint32_t>(padBytes, sizeof(zeros));
+        if (!writeBytes(f, zeros, n))
+          return false;
+        padBytes -= n;
+      }
+    }
+    if (!enc.isRef && !writePayload(f, enc.payload, enc.payloadBytes))
+      return false;
+  }
+
+  return true;
+}
+
+static bool writeParamRecord(AGXFileWriter &w,
+    uint32_t name,
+    const ParamData &p,
+    const AGXDeltaBase *base = nullptr)
+{
+  // Reference an earlier record with the same content, else delta-encode
+  // (unless quantized)
+  AGXRecordEncoding enc;
+  const ParamData *stored = &p;
+  {
+    AGXPhaseTimer t(
+        w.out.trace, "agx.write.encode", &w.out.stats->encodeSeconds);
+    const uint8_t mode = quantizationOf(*w.options, name, p);
+    enc.isRef = findDuplicate(w, p, mode, w.out.pos, enc.refOffset);
+    if (mode != AGX_QUANTIZE_NONE) {
+      describeQuantized(p, mode, w.quantized);
+      if (!enc.isRef)
+        quantizePayload(p, w.quantized);
+      enc.quantized = &w.quantized;
+      stored = &w.quantized.stored;
+    } else if (base && !enc.isRef) {
+      enc.base = base->data;
+      enc.baseOffset = base->recordOffset;
+    }
+    encodeRecord(*w.options, *stored, enc, w.delta, w.scratch);
+  }
+  return emitRecord(w.out, w.names->name(name), *stored, enc, *w.options);
+}
+
+// Reset 'w' to write with the options and name table of 'e'
+static void resetFileWriter(AGXFileWriter &w, AGXExporter_t &e)
+{
+  w = AGXFileWriter{};
+  w.options = &e.options;
+  w.names = &e.names;
+  w.out.stats = &e.stats;
+  w.out.trace = &e.trace;
+  w.out.bufferSize = e.options.writeBufferSize;
+  w.out.buffer.reserve(w.out.bufferSize);
+}
+
+static bool openFile(AGXFileWriter &w, const char *filename, AGXExporter_t &e)
+{
+  const AGXWriteOptions &options = e.options;
+  resetFileWriter(w, e);
+  if (options.ioBackend == AGX_IO_DIRECT) {
+    w.direct.reset(new (std::nothrow) AGXDirectWriter);
+    if (w.direct && w.direct->open(filename)) {
+      w.out.direct = w.direct.get();
+      return true;
+    }
+    w.direct.reset(); // not supported for this file, fall back to stdio
+  }
+  w.out.f = std::fopen(filename, "wb");
+  return w.out.f != nullptr;
+}
+
+template <typename T>
+static bool readPOD(std::FILE *f, T &v)
+{
+  return std::fread(&v, sizeof(T), 1, f) == 1;
+}
+
+// Read a TOC entry list which must hold 'count' entries, each within the
+// records before 'tocOffset'
+static bool loadTocEntries(std::FILE *f,
+    uint32_t count,
+    uint64_t tocOffset,
+    uint64_t fileSize,
+    std::vector<AGXTocEntry> &v)
+{
+  uint32_t stored = 0;
+  if (!readPOD(f, stored) || stored != count
+      || count > (fileSize - tocOffset) / sizeof(AGXTocEntry))
+    return false;
+  v.resize(count);
+  for (auto &e : v) {
+    if (!readPOD(f, e.offset) || !readPOD(f, e.size) || e.offset > tocOffset
+        || e.size > tocOffset - e.offset)
+      return false;
+  }
+  return true;
+}
+
+// Load the header and table of contents of the finished file 'f' into 'w' and
+// 'e', with 'w' set to write the new time steps over the old TOC
+static bool loadAppendState(std::FILE *f, AGXFileWriter &w, AGXExporter_t &e)
+{
+  // Footer
+  if (std::fseek(f, 0, SEEK_END) != 0)
+    return false;
+  const long end = std::ftell(f);
+  uint64_t tocOffset = 0;
+  char magic[4];
+  if (end < 12 || std::fseek(f, end - 12, SEEK_SET) != 0
+      || !readPOD(f, tocOffset) || std::fread(magic, 4, 1, f) != 1
+      || std::memcmp(magic, "AGXF", 4) != 0)
+    return false;
+  const uint64_t fileSize = static_cast<uint64_t>(end);
+  const uint64_t tocLimit = fileSize - 12;
+  if (tocOffset >= tocLimit)
+    return false;
+
+  // Header and subtype
+  uint32_t version = 0;
+  uint32_t endianMarker = 0;
+  uint32_t objectType = 0;
+  uint32_t timeSteps = 0;
+  uint32_t constantCount = 0;
+  uint32_t subtypeLen = 0;
+  if (std::fseek(f, 0, SEEK_SET) != 0 || std::fread(magic, 4, 1, f) != 1
+      || std::memcmp(magic, "AGXB", 4) != 0 || !readPOD(f, version)
+      || version < 8 || version > 10 || !readPOD(f, endianMarker)
+      || endianMarker != 0x01020304 || !readPOD(f, objectType)
+      || !readPOD(f, timeSteps) || !readPOD(f, constantCount)
+      || !readPOD(f, subtypeLen) || subtypeLen > tocOffset)
+    return false;
+  std::string subtype(subtypeLen, '\0');
+  if (subtypeLen > 0 && std::fread(&subtype[0], subtypeLen, 1, f) != 1)
+    return false;
+
+  // Table of contents, which must end at the footer
+  uint64_t timeStepsStart = 0;
+  if (std::fseek(f, static_cast<long>(tocOffset), SEEK_SET) != 0
+      || std::fread(magic, 4, 1, f) != 1 || std::memcmp(magic, "AGXT", 4) != 0
+      || !readPOD(f, timeStepsStart) || timeStepsStart > tocOffset
+      || !loadTocEntries(f, constantCount, tocOffset, fileSize, w.constantToc)
+      || !loadTocEntries(f, timeSteps, tocOffset, fileSize, w.timeStepToc))
+    return false;
+  w.timeStepTimes.resize(timeSteps);
+  for (auto &t : w.timeStepTimes) {
+    if (!readPOD(f, t))
+      return false;
+  }
+  if (std::ftell(f) != static_cast<long>(tocLimit))
+    return false;
+
+  w.out.pos = tocOffset;
+  w.headerWritten = true;
+  w.headerTimeSteps = timeSteps;
+  w.headerVersion = version;
+  w.timeStepsStart = timeStepsStart;
+  e.subtype = std::move(subtype);
+  e.timeSteps = timeSteps;
+  e.perTimeStep.resize(timeSteps);
+  e.stepTimes = w.timeStepTimes;
+  e.nextStep = timeSteps; // all written
+  return true;
+}
+
+// Open the finished file 'filename' to append time steps to it (stdio only).
+// The file is read through a separate stream: output goes to the descriptor
+// directly, whose offset a stream with buffered reads would leave elsewhere.
+static bool openFileForAppend(
+    AGXFileWriter &w, const char *filename, AGXExporter_t &e)
+{
+  resetFileWriter(w, e);
+  std::FILE *f = std::fopen(filename, "rb");
+  if (!f)
+    return false;
+  const bool loaded = loadAppendState(f, w, e);
+  std::fclose(f);
+  if (!loaded)
+    return false;
+
+  w.out.f = std::fopen(filename, "r+b");
+  if (w.out.f
+      && std::fseek(w.out.f, static_cast<long>(w.out.pos), SEEK_SET) == 0)
+    return true;
+  if (w.out.f)
+    std::fclose(w.out.f);
+  w.out.f = nullptr;
+  return false;
+}
+
+// Whether values or arrays 'a' and 'b' have the same type, count and bytes
+static bool sameContent(const ParamData &a, const ParamData &b)
+{
+  if (a.isArray != b.isArray || a.size() != b.size())
+    return false;
+  if (a.isArray
+      && (a.elementType != b.elementType || a.elementCount != b.elementCount
+          || a.dimensions != b.dimensions
+          || std::memcmp(a.numItems, b.numItems, sizeof(a.numItems)) != 0))
+    return false;
+  if (!a.isArray && a.type != b.type)
+    return false;
+  return a.size() == 0 || std::memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
+// Mark the time step parameters of 'e' which are the same in every time step
+// (and not also set as constants) to be written as constants
+static void findPromotedParams(AGXFileWriter &w, const AGXExporter_t *e)
+{
+  w.promoted.clear();
+  w.promotedCount = 0;
+  if (!w.options->promoteConstants || e->timeSteps < 2)
+    return;
+  AGXPhaseTimer t(
+      w.out.trace, "agx.write.encode", &w.out.stats->encodeSeconds);
+
+  const ParamList &first = e->perTimeStep[0];
+  for (size_t i = 0; i < first.params.size(); ++i) {
+    const AGXParam &param = first.params[i];
+    if (e->constants.find(param.name))
+      continue;
+    bool same = true;
+    for (uint32_t s = 1; same && s < e->timeSteps; ++s) {
+      const ParamData *other = e->perTimeStep[s].find(param.name, i);
+      same = other && sameContent(param.data, *other);
+    }
+    if (!same)
+      continue;
+    w.promoted.resize(e->names.names.size(), 0);
+    w.promoted[param.name] = 1;
+    w.promotedCount++;
+  }
+  w.out.stats->paramsPromoted += w.promotedCount;
+}
+
+static bool isPromoted(const AGXFileWriter &w, uint32_t name)
+{
+  return name < w.promoted.size() && w.promoted[name];
+}
+
+// Header, subtype and constants section (including promoted parameters)
+static bool writeHeader(AGXFileWriter &w, const AGXExporter_t *e)
+{
+  AGXOutput &f = w.out;
+
+  // Count constants
+  uint32_t constantCount =
+      static_cast<uint32_t>(e->constants.size()) + w.promotedCount;
+
+  // Header
+  const char magic[4] = {'A', 'G', 'X', 'B'};
+  uint32_t version = 10;
+  uint32_t endianMarker = 0x01020304;
+  uint32_t timeSteps = e->timeSteps;
+  uint32_t objectType = ANARI_GEOMETRY; // reserved for future configuration
+
+  bool ok = true;
+  ok = ok && writeBytes(f, magic, sizeof(magic));
+  ok = ok && writePOD(f, version);
+  ok = ok && writePOD(f, endianMarker);
+  ok = ok && writePOD(f, objectType);
+  ok = ok && writePOD(f, timeSteps);
+  ok = ok && writePOD(f, constantCount);
+
+  // Subtype
+  if (ok) {
+    const std::string &subtype = e->subtype;
+    uint32_t subtypeLen = static_cast<uint32_t>(subtype.size());
+    ok = ok && writePOD(f, subtypeLen);
+    if (subtypeLen > 0)
+      ok = ok && writeBytes(f, subtype.data(), subtypeLen);
+  }
+
+  // Constants section
+  w.constantToc.reserve(constantCount);
+  auto writeConstant = [&](const AGXParam &c) {
+    AGXTocEntry te;
+    te.offset = f.pos;
+    ok = writeParamRecord(w, c.name, c.data);
+    te.size = f.pos - te.offset;
+    w.constantToc.push_back(te);
+  };
+  for (size_t i = 0; ok && i < e->constants.params.size(); ++i)
+    writeConstant(e->constants.params[i]);
+  if (w.promotedCount > 0) {
+    for (size_t i = 0; ok && i < e->perTimeStep[0].params.size(); ++i) {
+      if (isPromoted(w, e->perTimeStep[0].params[i].name))
+        writeConstant(e->perTimeStep[0].params[i]);
+    }
+  }
+
+  w.headerWritten = true;
+  w.headerTimeSteps = timeSteps;
+  w.headerVersion = version;
+  w.timeStepsStart = f.pos;
+  return ok;
+}
+
+// Whether time step 'index' is stored without delta encoding
+static bool isKeyframe(
+    const AGXWriteOptions &opts, uint32_t index, const ParamList *prev)
+{
+  return !opts.deltaEncoding || !prev
+      || (opts.keyframeInterval ? index % opts.keyframeInterval == 0
+                                : index == 0);
+}
+
+// The array of the previous time step which array 'p' (at 'position' in its
+// step) can be delta-encoded against, if any
+static const ParamData *deltaBaseData(const ParamList &prev,
+    uint32_t name,
+    size_t position,
+    const ParamData &p)
+{
+  const ParamData *found = prev.find(name, position);
+  if (!found)
+    return nullptr;
+  const ParamData &b = *found;
+  if (!p.isArray || !b.isArray || b.elementType != p.elementType
+      || b.elementCount != p.elementCount || b.size() != p.size()
+      || p.size() == 0)
+    return nullptr;
+  return &b;
+}
+
+// Find the delta base for array 'p' in the previous time step, if any
+static bool findDeltaBase(const AGXFileWriter &w,
+    const ParamList &prev,
+    uint32_t name,
+    size_t position,
+    const ParamData &p,
+    AGXDeltaBase &base)
+{
+  if (name >= w.prevRecordOffsets.size() || w.prevRecordOffsets[name] == 0)
+    return false;
+  base.data = deltaBaseData(prev, name, position, p);
+  base.recordOffset = w.prevRecordOffsets[name];
+  return base.data != nullptr;
+}
+
+// Write one time step block; 'prev' holds the previous time step's data when
+// it can serve as delta base
+static bool writeTimeStep(AGXFileWriter &w,
+    uint32_t index,
+    double time,
+    const ParamList &m,
+    const ParamList *prev = nullptr)
+{
+  AGXOutput &f = w.out;
+  const AGXWriteOptions &opts = *w.options;
+  uint32_t paramCount = static_cast<uint32_t>(m.size());
+  if (w.promotedCount > 0) {
+    for (const auto &param : m.params)
+      paramCount -= isPromoted(w, param.name) ? 1 : 0;
+  }
+  AGXTocEntry te;
+  te.offset = f.pos;
+
+  const bool keyframe = isKeyframe(opts, index, prev);
+  if (opts.deltaEncoding)
+    w.curRecordOffsets.assign(w.names->names.size(), 0);
+
+  bool ok = writePOD(f, index) && writePOD(f, paramCount) && writePOD(f, time);
+  for (size_t i = 0; ok && i < m.params.size(); ++i) {
+    const AGXParam &param = m.params[i];
+    if (isPromoted(w, param.name))
+      continue; // written as a constant
+    AGXDeltaBase base;
+    const bool useBase = !keyframe
+        && findDeltaBase(w, *prev, param.name, i, param.data, base);
+    const uint64_t recordOffset = f.pos;
+    ok = writeParamRecord(
+        w, param.name, param.data, useBase ? &base : nullptr);
+    // Quantized arrays don't serve as delta bases, as their stored form
+    // differs from the data the next step is compared with
+    if (opts.deltaEncoding && param.data.isArray
+        && quantizationOf(opts, param.name, param.data) == AGX_QUANTIZE_NONE)
+      w.curRecordOffsets[param.name] = recordOffset;
+  }
+  if (!ok)
+    return false;
+  std::swap(w.prevRecordOffsets, w.curRecordOffsets);
+
+  te.size = f.pos - te.offset;
+  w.timeStepToc.push_back(te);
+  w.timeStepTimes.push_back(time);
+  return true;
+}
+
+// Write the table of contents, fix up the header's time step count and
+// version if they changed since the header was written, and close the file
+static bool finishFile(AGXFileWriter &w)
+{
+  const uint32_t timeSteps = static_cast<uint32_t>(w.timeStepToc.size());
+  const uint32_t version = 10; // as in writeHeader()
+  bool ok = w.ok
+      && writeToc(w.out,
+          w.timeStepsStart,
+          w.constantToc,
+          w.timeStepToc,
+          w.timeStepTimes)
+      && flushOutput(w.out);
+  const long versionField = 4; // magic
+  const long timeStepsField = 16; // magic + version + endianMarker + type
+
+  if (w.direct) {
+    // Direct output ends on a block boundary until finish() trims it
+    ok = w.direct->finish(w.out.pos) && ok;
+    if (ok && timeSteps != w.headerTimeSteps)
+      ok = w.direct->patch(timeStepsField, &timeSteps, sizeof(timeSteps));
+    if (ok && version != w.headerVersion)
+      ok = w.direct->patch(versionField, &version, sizeof(version));
+    ok = w.direct->close() && ok;
+    w.direct.reset();
+    w.out.direct = nullptr;
+    w.ok = ok;
+    return ok;
+  }
+
+  if (ok && timeSteps != w.headerTimeSteps) {
+    ok = std::fseek(w.out.f, timeStepsField, SEEK_SET) == 0
+        && std::fwrite(&timeSteps, sizeof(timeSteps), 1, w.out.f) == 1;
+  }
+  if (ok && version != w.headerVersion) {
+    ok = std::fseek(w.out.f, versionField, SEEK_SET) == 0
+        && std::fwrite(&version, sizeof(version), 1, w.out.f) == 1;
+  }
+
+  if (std::fclose(w.out.f) != 0)
+    ok = false;
+  w.out.f = nullptr;
+  w.ok = ok;
+  return ok;
+}
+
+#ifndef _WIN32
+// Parallel agxWrite() /////////////////////////////////////////////////////////
+
+// Run fn(i) for all i in [0, n) on up to 'threads' threads
+template <typename F>
+static void parallelFor(uint32_t n, uint32_t threads, const F &fn)
+{
+  const uint32_t count = std::min(n, threads);
+  if (count <= 1) {
+    for (uint32_t i = 0; i < n; ++i)
+      fn(i);
+    return;
+  }
+
+  std::atomic<uint32_t> next{0};
+  auto worker = [&]() {
+    for (uint32_t i = next++; i < n; i = next++)
+      fn(i);
+  };
+  std::vector<std::thread> pool;
+  pool.reserve(count - 1);
+  for (uint32_t t = 1; t < count; ++t)
+    pool.emplace_back(worker);
+  worker();
+  for (auto &t : pool)
+    t.join();
+}
+
+// A record of a time step prepared by the parallel writer
+struct AGXPreparedRecord
+{
+  uint32_t name{0};
+  const ParamData *data{nullptr};
+  uint8_t quantization{AGX_QUANTIZE_NONE};
+  AGXQuantized quantized;
+  bool dedupCandidate{false};
+  AGXContentKey key;
+  AGXDedupEntry *content{nullptr}; // dedup entry of this content, if any
+  AGXRecordEncoding enc;
+  std::vector<uint8_t> delta;
+  std::vector<uint8_t> compressed;
+};
+
+// The array a prepared record stores: its data, or its quantized form
+static const ParamData &storedData(const AGXPreparedRecord &rec)
+{
+  return rec.quantization != AGX_QUANTIZE_NONE ? rec.quantized.stored
+                                               : *rec.data;
+}
+
+// A time step prepared by the parallel writer: its records, then the block as
+// staged headers interleaved with references to the payloads
+struct AGXPreparedStep
+{
+  std::vector<AGXPreparedRecord> records;
+  uint64_t offset{0};
+  std::vector<uint8_t> staging;
+  std::vector<AGXSegment> segments;
+};
+
+// Write the time steps of 'e' in batches of 'threads' steps. Hashing and
+// encoding the payloads, and writing the blocks, run in parallel per
+// time step; resolving duplicates and delta bases and laying out the blocks
+// run serially in step order, so the file matches the serial writer's output.
+// Headers are staged per block while payloads are written from where they
+// are, gathered with pwritev() (or passed in order to a direct I/O output,
+// which overlaps the writes itself).
+static bool writeTimeStepsParallel(
+    AGXFileWriter &w, const AGXExporter_t *e, uint32_t threads)
+{
+  const AGXWriteOptions &opts = *w.options;
+  if (!flushOutput(w.out))
+    return false;
+  AGXDirectWriter *direct = w.out.direct;
+  const int fd = direct ? -1 : fileno(w.out.f);
+
+  std::vector<AGXPreparedStep> batch;
+  for (uint32_t first = 0; first < e->timeSteps; first += threads) {
+    const uint32_t count = std::min(threads, e->timeSteps - first);
+    batch.clear();
+    batch.resize(count);
+    AGXPhaseTimer encodeTimer(
+        w.out.trace, "agx.write.encode", &w.out.stats->encodeSeconds);
+
+    // Collect records and hash dedup candidates
+    parallelFor(count, threads, [&](uint32_t i) {
+      const ParamList &m = e->perTimeStep[first + i];
+      AGXPreparedStep &s = batch[i];
+      s.records.reserve(m.size());
+      for (const auto &param : m.params) {
+        if (isPromoted(w, param.name))
+          continue; // written as a constant
+        AGXPreparedRecord rec;
+        rec.name = param.name;
+        rec.data = &param.data;
+        rec.quantization = quantizationOf(opts, param.name, param.data);
+        if (rec.quantization != AGX_QUANTIZE_NONE)
+          describeQuantized(param.data, rec.quantization, rec.quantized);
+        rec.dedupCandidate = isDedupCandidate(opts, param.data);
+        if (rec.dedupCandidate)
+          rec.key = contentKey(param.data, rec.quantization);
+        s.records.push_back(std::move(rec));
+      }
+    });
+
+    // Resolve duplicates and delta bases
+    for (uint32_t i = 0; i < count; ++i) {
+      const uint32_t index = first + i;
+      const ParamList *prev =
+          index > 0 ? &e->perTimeStep[index - 1] : nullptr;
+      const bool keyframe = isKeyframe(opts, index, prev);
+      auto &records = batch[i].records;
+      for (size_t j = 0; j < records.size(); ++j) {
+        AGXPreparedRecord &rec = records[j];
+        if (rec.dedupCandidate)
+          rec.content = matchContent(w, *rec.data, rec.key, rec.enc.isRef);
+        if (!keyframe && !rec.enc.isRef
+            && rec.quantization == AGX_QUANTIZE_NONE)
+          rec.enc.base = deltaBaseData(*prev, rec.name, j, *rec.data);
+      }
+    }
+
+    // Encode payloads
+    parallelFor(count, threads, [&](uint32_t i) {
+      for (auto &rec : batch[i].records) {
+        if (rec.quantization != AGX_QUANTIZE_NONE) {
+          if (!rec.enc.isRef)
+            quantizePayload(*rec.data, rec.quantized);
+          rec.enc.quantized = &rec.quantized;
+        }
+        encodeRecord(
+            opts, storedData(rec), rec.enc, rec.delta, rec.compressed);
+      }
+    });
+    encodeTimer.stop();
+
+    // Lay out the blocks, which fixes all record offsets
+    for (uint32_t i = 0; i < count; ++i) {
+      const uint32_t index = first + i;
+      AGXPreparedStep &s = batch[i];
+      AGXOutput staged;
+      staged.stats = w.out.stats; // counts records, never flushes
+      staged.pos = w.out.pos;
+      staged.staging = &s.staging;
+      staged.segments = &s.segments;
+      s.offset = staged.pos;
+
+      uint32_t paramCount = static_cast<uint32_t>(s.records.size());
+      const double time = e->stepTimes[index];
+      writePOD(staged, index);
+      writePOD(staged, paramCount);
+      writePOD(staged, time);
+      if (opts.deltaEncoding)
+        w.curRecordOffsets.assign(e->names.names.size(), 0);
+      for (auto &rec : s.records) {
+        const uint64_t recordOffset = staged.pos;
+        if (rec.enc.isRef)
+          rec.enc.refOffset = rec.content->recordOffset;
+        else if (rec.content)
+          rec.content->recordOffset = recordOffset;
+        if (rec.enc.base)
+          rec.enc.baseOffset = w.prevRecordOffsets[rec.name];
+        emitRecord(
+            staged, e->names.name(rec.name), storedData(rec), rec.enc, opts);
+        if (opts.deltaEncoding && rec.data->isArray
+            && rec.quantization == AGX_QUANTIZE_NONE)
+          w.curRecordOffsets[rec.name] = recordOffset;
+      }
+      std::swap(w.prevRecordOffsets, w.curRecordOffsets);
+
+      AGXTocEntry te;
+      te.offset = s.offset;
+      te.size = staged.pos - s.offset;
+      w.timeStepToc.push_back(te);
+      w.timeStepTimes.push_back(time);
+      w.out.pos = staged.pos;
+    }
+
+    // Write the blocks, each with one gathered write
+    std::atomic<bool> ok{true};
+    auto writeBlock = [&](uint32_t i) {
+      AGXPreparedStep &s = batch[i];
+      std::vector<struct iovec> iov;
+      iov.reserve(2 * s.segments.size() + 1);
+      auto add = [&](const void *data, size_t n) {
+        if (n == 0)
+          return;
+        struct iovec v;
+        v.iov_base = const_cast<void *>(data);
+        v.iov_len = n;
+        iov.push_back(v);
+      };
+      size_t staged = 0;
+      for (const auto &seg : s.segments) {
+        add(s.staging.data() + staged, seg.stagedEnd - staged);
+        add(seg.data, seg.size);
+        staged = seg.stagedEnd;
+      }
+      add(s.staging.data() + staged, s.staging.size() - staged);
+      if (direct) {
+        for (size_t j = 0; ok && j < iov.size(); ++j)
+          ok = direct->write(iov[j].iov_base, iov[j].iov_len);
+      } else if (!writeGathered(
+                     fd, iov.data(), static_cast<int>(iov.size()), &s.offset))
+        ok = false;
+    };
+    AGXPhaseTimer outputTimer(
+        w.out.trace, "agx.write.output", &w.out.stats->outputSeconds);
+    parallelFor(count, direct ? 1 : threads, writeBlock); // direct: in order
+    outputTimer.stop();
+    if (!ok)
+      return false;
+    w.out.stats->bytesWritten += w.out.pos - batch.front().offset; // blocks
+  }
+
+  // Continue sequentially (the TOC) after the last block
+  if (direct)
+    return true;
+  return ::lseek(fd, static_cast<off_t>(w.out.pos), SEEK_SET)
+      == static_cast<off_t>(w.out.pos);
+}
+#endif
+
+// Write out completed time steps of a streaming exporter, in index order. With
+// 'all' set, every remaining time step is written regardless of completion.
+static void flushStreamedTimeSteps(AGXExporter_t *e, bool all)
+{
+  AGXFileWriter &w = e->stream;
+  auto ready = [&]() {
+    return e->nextStep < e->timeSteps
+        && (all
+            || (e->nextStep < e->stepEnded.size()
+                && e->stepEnded[e->nextStep]));
+  };
+  if (!all && !ready())
+    return; // nothing to write yet
+  AGXPhaseTimer t(&e->trace, "agx.write", &e->stats.writeSeconds);
+
+  if (!w.headerWritten && (ready() || all)) {
+    w.ok = writeHeader(w, e);
+    releaseDedupData(w);
+    e->constants = ParamList(); // written, no longer needed
+  }
+
+  while (w.ok && ready()) {
+    ParamList &m = e->perTimeStep[e->nextStep];
+    w.ok = writeTimeStep(
+        w, e->nextStep, e->stepTimes[e->nextStep], m, &e->streamPrevStep);
+    releaseDedupData(w);
+    if (e->options.deltaEncoding)
+      e->streamPrevStep = std::move(m); // keep until the next step is written
+    m = ParamList(); // release the step's memory
+    e->nextStep++;
+  }
+
+  // Completed time steps don't linger in the write buffer
+  if (w.ok && w.headerWritten)
+    w.ok = flushOutput(w.out);
+}
+
+// Streaming exporters can no longer change data which was already written
+static bool acceptsConstantEdits(AGXExporter_t *e)
+{
+  if (e->streaming && e->stream.headerWritten) {
+    e->droppedEdits = true;
+    return false;
+  }
+  return true;
+}
+
+static bool acceptsTimeStepEdits(AGXExporter_t *e, uint32_t timeStepIndex)
+{
+  if (e->streaming && timeStepIndex < e->nextStep) {
+    e->droppedEdits = true;
+    return false;
+  }
+  return true;
+}
+
+// The parameters of time step 'timeStepIndex' (clamped to the valid range),
+// or nullptr if they can't be edited
+static ParamList *editableTimeStep(AGXExporter_t *e, uint32_t timeStepIndex)
+{
+  if (e->timeSteps == 0)
+    return nullptr;
+  timeStepIndex = clampToValidIndex(timeStepIndex, e->timeSteps - 1);
+  if (e->perTimeStep.size() != e->timeSteps)
+    e->perTimeStep.resize(e->timeSteps);
+  if (!acceptsTimeStepEdits(e, timeStepIndex))
+    return nullptr;
+  return &e->perTimeStep[timeStepIndex];
+}
+
+// Make 'p' an array of 'dimensions' (1..3) dimensions of numItems[d] elements
+// each. Returns false if its size doesn't fit in memory.
+static bool setArrayShape(ParamData &p,
+    ANARIDataType elementType,
+    uint8_t dimensions,
+    const uint64_t *numItems)
+{
+  uint64_t count = 1;
+  for (uint8_t d = 0; d < dimensions; ++d) {
+    if (numItems[d] != 0 && count > UINT64_MAX / numItems[d])
+      return false;
+    count *= numItems[d];
+  }
+  const uint64_t elementBytes = agxSizeOf(elementType);
+  if (elementBytes != 0 && count > SIZE_MAX / elementBytes)
+    return false;
+  p.isArray = true;
+  p.elementType = elementType;
+  p.elementCount = count;
+  p.dimensions = dimensions;
+  for (uint8_t d = 0; d < 3; ++d)
+    p.numItems[d] = d < dimensions ? numItems[d] : 1;
+  return true;
+}
+
+// Copy array 'data' into parameter 'name' of 'list', a section of 'e'
+static void setArray(AGXExporter_t *e,
+    ParamList &list,
+    const char *name,
+    ANARIDataType elementType,
+    const void *data,
+    uint8_t dimensions,
+    const uint64_t *numItems)
+{
+  ParamData p;
+  if (!setArrayShape(p, elementType, dimensions, numItems))
+    return;
+  const uint32_t id = e->names.intern(name);
+  const size_t total =
+      static_cast<size_t>(agxSizeOf(elementType) * p.elementCount);
+  if (!copyBytes(e, list, id, p, data, total))
+    return;
+  list.set(id, std::move(p));
+}
+
+// Make 'p' the shared array at 'appMemory', taking ownership of it even if
+// its size doesn't fit in memory (then returns false)
+static bool shareArray(ParamData &p,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint8_t dimensions,
+    const uint64_t *numItems,
+    AGXMemoryDeleter deleter,
+    const void *userData)
+{
+  const bool ok = setArrayShape(p, elementType, dimensions, numItems);
+  const uint64_t nbytes = ok ? agxSizeOf(elementType) * p.elementCount : 0;
+  shareBytes(p, appMemory, static_cast<size_t>(nbytes), deleter, userData);
+  return ok;
+}
+
+static void setConstantArray(AGXExporter_t *e,
+    const char *name,
+    ANARIDataType elementType,
+    const void *data,
+    uint8_t dimensions,
+    const uint64_t *numItems)
+{
+  if (!e || !name || !acceptsConstantEdits(e))
+    return;
+  setArray(e, e->constants, name, elementType, data, dimensions, numItems);
+}
+
+static void setConstantArrayShared(AGXExporter_t *e,
+    const char *name,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint8_t dimensions,
+    const uint64_t *numItems,
+    AGXMemoryDeleter deleter,
+    const void *userData)
+{
+  // Take ownership first so rejected memory is handed back right away
+  ParamData p;
+  const bool ok = shareArray(
+      p, elementType, appMemory, dimensions, numItems, deleter, userData);
+  if (!ok || !e || !name || !acceptsConstantEdits(e))
+    return;
+  e->constants.set(e->names.intern(name), std::move(p));
+}
+
+static void setTimeStepArray(AGXExporter_t *e,
+    uint32_t timeStepIndex,
+    const char *name,
+    ANARIDataType elementType,
+    const void *data,
+    uint8_t dimensions,
+    const uint64_t *numItems)
+{
+  if (!e || !name)
+    return;
+  ParamList *step = editableTimeStep(e, timeStepIndex);
+  if (step)
+    setArray(e, *step, name, elementType, data, dimensions, numItems);
+}
+
+static void setTimeStepArrayShared(AGXExporter_t *e,
+    uint32_t timeStepIndex,
+    const char *name,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint8_t dimensions,
+    const uint64_t *numItems,
+    AGXMemoryDeleter deleter,
+    const void *userData)
+{
+  ParamData p;
+  const bool ok = shareArray(
+      p, elementType, appMemory, dimensions, numItems, deleter, userData);
+  if (!ok || !e || !name)
+    return;
+  ParamList *step = editableTimeStep(e, timeStepIndex);
+  if (step)
+    step->set(e->names.intern(name), std::move(p));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public API definitions /////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+extern "C" {
+
+AGXExporter agxNewExporter()
+{
+  return new (std::nothrow) AGXExporter_t{};
+}
+
+void agxReleaseExporter(AGXExporter exporter)
+{
+  if (exporter && exporter->streaming)
+    agxEndStreaming(exporter);
+  delete exporter;
+}
+
+void agxSetObjectSubtype(AGXExporter exporter, const char *subtype)
+{
+  if (!exporter || !acceptsConstantEdits(exporter))
+    return;
+  exporter->subtype = subtype ? std::string(subtype) : std::string{};
+}
+
+void agxSetTimeStepCount(AGXExporter exporter, uint32_t count)
+{
+  if (!exporter)
+    return;
+  if (exporter->streaming)
+    count = std::max(count, exporter->nextStep); // can't drop written steps
+  exporter->timeSteps = count;
+  exporter->perTimeStep.resize(count);
+  const size_t set = std::min<size_t>(exporter->stepTimes.size(), count);
+  exporter->stepTimes.resize(count);
+  for (size_t i = set; i < count; ++i)
+    exporter->stepTimes[i] = static_cast<double>(i);
+}
+
+void agxSetTimeStepTime(
+    AGXExporter exporter, uint32_t timeStepIndex, double time)
+{
+  if (!exporter || timeStepIndex >= exporter->timeSteps
+      || !acceptsTimeStepEdits(exporter, timeStepIndex))
+    return;
+  exporter->stepTimes[timeStepIndex] = time;
 }
 
 uint32_t agxGetTimeStepCount(AGXExporter exporter)
@@ -264,14 +2806,173 @@ uint32_t agxGetTimeStepCount(AGXExporter exporter)
   return exporter->timeSteps;
 }
 
+void agxSetCompression(AGXExporter exporter, AGXCodec codec, int level)
+{
+  if (!exporter)
+    return;
+  exporter->options.codec = codec;
+  exporter->options.codecLevel = level;
+}
+
+void agxSetArrayQuantization(
+    AGXExporter exporter, const char *name, AGXQuantization mode)
+{
+  if (!exporter || !name || mode < AGX_QUANTIZE_NONE
+      || mode > AGX_QUANTIZE_BOUNDS16)
+    return;
+  const uint32_t id = exporter->names.intern(name);
+  std::vector<uint8_t> &modes = exporter->options.quantization;
+  if (id >= modes.size())
+    modes.resize(id + 1, AGX_QUANTIZE_NONE);
+  modes[id] = static_cast<uint8_t>(mode);
+}
+
+void agxSetDeltaEncoding(
+    AGXExporter exporter, int enable, uint32_t keyframeInterval)
+{
+  if (!exporter)
+    return;
+  exporter->options.deltaEncoding = enable != 0;
+  exporter->options.keyframeInterval = keyframeInterval;
+}
+
+void agxSetDeduplication(AGXExporter exporter, int enable)
+{
+  if (!exporter)
+    return;
+  exporter->options.deduplicate = enable != 0;
+}
+
+void agxSetConstantPromotion(AGXExporter exporter, int enable)
+{
+  if (!exporter)
+    return;
+  exporter->options.promoteConstants = enable != 0;
+}
+
+void agxSetWriteBufferSize(AGXExporter exporter, size_t bytes)
+{
+  if (!exporter)
+    return;
+  exporter->options.writeBufferSize = bytes ? bytes : AGX_DEFAULT_WRITE_BUFFER;
+}
+
+void agxSetArrayChunking(AGXExporter exporter, uint64_t chunkBytes)
+{
+  if (!exporter)
+    return;
+  exporter->options.chunkBytes = chunkBytes;
+}
+
+void agxSetPayloadAlignment(AGXExporter exporter, uint32_t alignment)
+{
+  if (!exporter || alignment > AGX_MAX_PAYLOAD_ALIGNMENT
+      || (alignment & (alignment - 1)) != 0)
+    return;
+  exporter->options.payloadAlignment = alignment;
+}
+
+void agxSetWriteThreadCount(AGXExporter exporter, uint32_t threads)
+{
+  if (!exporter)
+    return;
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  exporter->options.writeThreads = threads;
+}
+
+int agxSetIOBackend(AGXExporter exporter, AGXIOBackend backend)
+{
+  if (!exporter)
+    return 1;
+  switch (backend) {
+  case AGX_IO_STDIO:
+    break;
+#ifdef AGX_HAS_DIRECT_IO
+  case AGX_IO_DIRECT:
+    break;
+#endif
+  default:
+    return 1;
+  }
+  exporter->options.ioBackend = backend;
+  return 0;
+}
+
+int agxExporterGetStats(AGXExporter exporter, AGXExporterStats *out)
+{
+  if (!exporter || !out)
+    return 1;
+  *out = exporter->stats;
+  return 0;
+}
+
+void agxExporterResetStats(AGXExporter exporter)
+{
+  if (exporter)
+    exporter->stats = AGXExporterStats{};
+}
+
+void agxExporterSetTraceHooks(AGXExporter exporter,
+    AGXTraceBeginCallback begin,
+    AGXTraceEndCallback end,
+    const void *userData)
+{
+  if (!exporter)
+    return;
+  exporter->trace.begin = begin;
+  exporter->trace.end = end;
+  exporter->trace.userData = userData;
+}
+
+int agxSetAllocator(AGXExporter exporter,
+    AGXAllocateCallback allocate,
+    AGXFreeCallback deallocate,
+    const void *userData)
+{
+  if (!exporter || exporter->pool.liveBlocks > 0)
+    return 1;
+  AGXBlockPool &pool = exporter->pool;
+  pool.trim(0); // cached blocks belong to the previous allocator
+  pool.allocator.allocate = allocate;
+  pool.allocator.free = deallocate;
+  pool.allocator.userData = userData;
+  return 0;
+}
+
+int agxCodecSupported(AGXCodec codec)
+{
+  switch (codec) {
+  case AGX_CODEC_NONE:
+    return 1;
+#ifdef AGX_WITH_LZ4
+  case AGX_CODEC_LZ4:
+    return 1;
+#endif
+#ifdef AGX_WITH_ZSTD
+  case AGX_CODEC_ZSTD:
+    return 1;
+#endif
+  default:
+    return 0;
+  }
+}
+
 void agxBeginTimeStep(AGXExporter exporter, uint32_t /*timeStepIndex*/)
 {
   (void)exporter; // no-op
 }
 
-void agxEndTimeStep(AGXExporter exporter, uint32_t /*timeStepIndex*/)
+void agxEndTimeStep(AGXExporter exporter, uint32_t timeStepIndex)
 {
-  (void)exporter; // no-op
+  if (!exporter || !exporter->streaming)
+    return; // no-op
+  if (timeStepIndex >= exporter->timeSteps)
+    return;
+  if (exporter->stepEnded.size() < exporter->timeSteps)
+    exporter->stepEnded.resize(exporter->timeSteps, 0);
+  exporter->stepEnded[timeStepIndex] = 1;
+  flushStreamedTimeSteps(exporter, false);
 }
 
 void agxSetParameter(AGXExporter exporter,
@@ -279,14 +2980,16 @@ void agxSetParameter(AGXExporter exporter,
     ANARIDataType type,
     const void *value)
 {
-  if (!exporter || !name)
+  if (!exporter || !name || !acceptsConstantEdits(exporter))
     return;
+  const uint32_t id = exporter->names.intern(name);
   ParamData p;
   p.isArray = false;
   p.type = type;
   const size_t nbytes = agxSizeOf(type);
-  copyBytes(p, value, nbytes);
-  exporter->constants[std::string(name)] = std::move(p);
+  if (!copyBytes(exporter, exporter->constants, id, p, value, nbytes))
+    return;
+  exporter->constants.set(id, std::move(p));
 }
 
 void agxSetParameterArray1D(AGXExporter exporter,
@@ -295,16 +2998,77 @@ void agxSetParameterArray1D(AGXExporter exporter,
     const void *data,
     uint64_t elementCount)
 {
-  if (!exporter || !name)
-    return;
-  ParamData p;
-  p.isArray = true;
-  p.elementType = elementType;
-  p.elementCount = elementCount;
-  const size_t elemBytes = agxSizeOf(elementType);
-  const size_t total = elemBytes * elementCount;
-  copyBytes(p, data, total);
-  exporter->constants[std::string(name)] = std::move(p);
+  setConstantArray(exporter, name, elementType, data, 1, &elementCount);
+}
+
+void agxSetParameterArray1DShared(AGXExporter exporter,
+    const char *name,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint64_t elementCount,
+    AGXMemoryDeleter deleter,
+    const void *userData)
+{
+  setConstantArrayShared(exporter,
+      name,
+      elementType,
+      appMemory,
+      1,
+      &elementCount,
+      deleter,
+      userData);
+}
+
+void agxSetParameterArray2D(AGXExporter exporter,
+    const char *name,
+    ANARIDataType elementType,
+    const void *data,
+    uint64_t numItems1,
+    uint64_t numItems2)
+{
+  const uint64_t numItems[2] = {numItems1, numItems2};
+  setConstantArray(exporter, name, elementType, data, 2, numItems);
+}
+
+void agxSetParameterArray3D(AGXExporter exporter,
+    const char *name,
+    ANARIDataType elementType,
+    const void *data,
+    uint64_t numItems1,
+    uint64_t numItems2,
+    uint64_t numItems3)
+{
+  const uint64_t numItems[3] = {numItems1, numItems2, numItems3};
+  setConstantArray(exporter, name, elementType, data, 3, numItems);
+}
+
+void agxSetParameterArray2DShared(AGXExporter exporter,
+    const char *name,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint64_t numItems1,
+    uint64_t numItems2,
+    AGXMemoryDeleter deleter,
+    const void *userData)
+{
+  const uint64_t numItems[2] = {numItems1, numItems2};
+  setConstantArrayShared(
+      exporter, name, elementType, appMemory, 2, numItems, deleter, userData);
+}
+
+void agxSetParameterArray3DShared(AGXExporter exporter,
+    const char *name,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint64_t numItems1,
+    uint64_t numItems2,
+    uint64_t numItems3,
+    AGXMemoryDeleter deleter,
+    const void *userData)
+{
+  const uint64_t numItems[3] = {numItems1, numItems2, numItems3};
+  setConstantArrayShared(
+      exporter, name, elementType, appMemory, 3, numItems, deleter, userData);
 }
 
 void agxSetTimeStepParameter(AGXExporter exporter,
@@ -319,13 +3083,18 @@ void agxSetTimeStepParameter(AGXExporter exporter,
       timeStepIndex, exporter->timeSteps ? exporter->timeSteps - 1 : 0);
   if (exporter->perTimeStep.size() != exporter->timeSteps)
     exporter->perTimeStep.resize(exporter->timeSteps);
+  if (!acceptsTimeStepEdits(exporter, timeStepIndex))
+    return;
 
+  ParamList &step = exporter->perTimeStep[timeStepIndex];
+  const uint32_t id = exporter->names.intern(name);
   ParamData p;
   p.isArray = false;
   p.type = type;
   const size_t nbytes = agxSizeOf(type);
-  copyBytes(p, value, nbytes);
-  exporter->perTimeStep[timeStepIndex][std::string(name)] = std::move(p);
+  if (!copyBytes(exporter, step, id, p, value, nbytes))
+    return;
+  step.set(id, std::move(p));
 }
 
 void agxSetTimeStepParameterArray1D(AGXExporter exporter,
@@ -335,89 +3104,220 @@ void agxSetTimeStepParameterArray1D(AGXExporter exporter,
     const void *data,
     uint64_t elementCount)
 {
-  if (!exporter || !name)
-    return;
-  timeStepIndex = clampToValidIndex(
-      timeStepIndex, exporter->timeSteps ? exporter->timeSteps - 1 : 0);
-  if (exporter->perTimeStep.size() != exporter->timeSteps)
-    exporter->perTimeStep.resize(exporter->timeSteps);
+  setTimeStepArray(
+      exporter, timeStepIndex, name, elementType, data, 1, &elementCount);
+}
 
-  ParamData p;
-  p.isArray = true;
-  p.elementType = elementType;
-  p.elementCount = elementCount;
-  const size_t elemBytes = agxSizeOf(elementType);
-  const size_t total = elemBytes * elementCount;
-  copyBytes(p, data, total);
-  exporter->perTimeStep[timeStepIndex][std::string(name)] = std::move(p);
+void agxSetTimeStepParameterArray1DShared(AGXExporter exporter,
+    uint32_t timeStepIndex,
+    const char *name,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint64_t elementCount,
+    AGXMemoryDeleter deleter,
+    const void *userData)
+{
+  setTimeStepArrayShared(exporter,
+      timeStepIndex,
+      name,
+      elementType,
+      appMemory,
+      1,
+      &elementCount,
+      deleter,
+      userData);
+}
+
+void agxSetTimeStepParameterArray2D(AGXExporter exporter,
+    uint32_t timeStepIndex,
+    const char *name,
+    ANARIDataType elementType,
+    const void *data,
+    uint64_t numItems1,
+    uint64_t numItems2)
+{
+  const uint64_t numItems[2] = {numItems1, numItems2};
+  setTimeStepArray(
+      exporter, timeStepIndex, name, elementType, data, 2, numItems);
+}
+
+void agxSetTimeStepParameterArray3D(AGXExporter exporter,
+    uint32_t timeStepIndex,
+    const char *name,
+    ANARIDataType elementType,
+    const void *data,
+    uint64_t numItems1,
+    uint64_t numItems2,
+    uint64_t numItems3)
+{
+  const uint64_t numItems[3] = {numItems1, numItems2, numItems3};
+  setTimeStepArray(
+      exporter, timeStepIndex, name, elementType, data, 3, numItems);
+}
+
+void agxSetTimeStepParameterArray2DShared(AGXExporter exporter,
+    uint32_t timeStepIndex,
+    const char *name,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint64_t numItems1,
+    uint64_t numItems2,
+    AGXMemoryDeleter deleter,
+    const void *userData)
+{
+  const uint64_t numItems[2] = {numItems1, numItems2};
+  setTimeStepArrayShared(exporter,
+      timeStepIndex,
+      name,
+      elementType,
+      appMemory,
+      2,
+      numItems,
+      deleter,
+      userData);
+}
+
+void agxSetTimeStepParameterArray3DShared(AGXExporter exporter,
+    uint32_t timeStepIndex,
+    const char *name,
+    ANARIDataType elementType,
+    const void *appMemory,
+    uint64_t numItems1,
+    uint64_t numItems2,
+    uint64_t numItems3,
+    AGXMemoryDeleter deleter,
+    const void *userData)
+{
+  const uint64_t numItems[3] = {numItems1, numItems2, numItems3};
+  setTimeStepArrayShared(exporter,
+      timeStepIndex,
+      name,
+      elementType,
+      appMemory,
+      3,
+      numItems,
+      deleter,
+      userData);
 }
 
 int agxWrite(AGXExporter exporter, const char *filename)
 {
-  if (!exporter || !filename)
+  if (!exporter || !filename || exporter->streaming)
     return 1;
 
-  std::FILE *f = std::fopen(filename, "wb");
-  if (!f)
+  AGXFileWriter w;
+  if (!openFile(w, filename, *exporter))
     return 2;
 
-  // Count constants
-  uint32_t constantCount = static_cast<uint32_t>(exporter->constants.size());
+  AGXPhaseTimer t(&exporter->trace, "agx.write", &exporter->stats.writeSeconds);
+  findPromotedParams(w, exporter);
+  w.ok = writeHeader(w, exporter);
+#ifndef _WIN32
+  const uint32_t threads = exporter->options.writeThreads;
+  if (w.ok && threads > 1 && exporter->timeSteps > 1) {
+    w.ok = writeTimeStepsParallel(w, exporter, threads);
+    return finishFile(w) ? 0 : 3;
+  }
+#endif
+  for (uint32_t i = 0; w.ok && i < exporter->timeSteps; ++i)
+    w.ok = writeTimeStep(w,
+        i,
+        exporter->stepTimes[i],
+        exporter->perTimeStep[i],
+        i > 0 ? &exporter->perTimeStep[i - 1] : nullptr);
 
-  // Header
-  const char magic[4] = {'A', 'G', 'X', 'B'};
-  uint32_t version = 1;
-  uint32_t endianMarker = 0x01020304;
-  uint32_t timeSteps = exporter->timeSteps;
-  uint32_t objectType = ANARI_GEOMETRY; // reserved for future configuration
+  return finishFile(w) ? 0 : 3;
+}
 
-  bool ok = true;
-  ok = ok && writeBytes(f, magic, sizeof(magic));
-  ok = ok && writePOD(f, version);
-  ok = ok && writePOD(f, endianMarker);
-  ok = ok && writePOD(f, objectType);
-  ok = ok && writePOD(f, timeSteps);
-  ok = ok && writePOD(f, constantCount);
+int agxBeginStreaming(AGXExporter exporter, const char *filename)
+{
+  if (!exporter || !filename || exporter->streaming)
+    return 1;
+  if (!openFile(exporter->stream, filename, *exporter))
+    return 2;
 
-  // Subtype
-  if (ok) {
-    const std::string &subtype = exporter->subtype;
-    uint32_t subtypeLen = static_cast<uint32_t>(subtype.size());
-    ok = ok && writePOD(f, subtypeLen);
-    if (subtypeLen > 0)
-      ok = ok && writeBytes(f, subtype.data(), subtypeLen);
-  }
+  exporter->streaming = true;
+  exporter->stepEnded.clear();
+  exporter->streamPrevStep = ParamList();
+  exporter->nextStep = 0;
+  exporter->droppedEdits = false;
+  return 0;
+}
 
-  // Constants section
-  if (ok) {
-    for (const auto &kv : exporter->constants) {
-      ok = writeParamRecord(f, kv.first, kv.second);
-      if (!ok)
-        break;
-    }
+int agxEndStreaming(AGXExporter exporter)
+{
+  if (!exporter || !exporter->streaming)
+    return 1;
+
+  flushStreamedTimeSteps(exporter, true);
+  AGXPhaseTimer t(&exporter->trace, "agx.write", &exporter->stats.writeSeconds);
+  const bool ok = finishFile(exporter->stream);
+  t.stop();
+  exporter->streaming = false;
+  exporter->stepEnded.clear();
+  exporter->streamPrevStep = ParamList();
+
+  if (!ok)
+    return 3;
+  return exporter->droppedEdits ? 4 : 0;
+}
+
+AGXExporter agxOpenExporterForAppend(const char *filename)
+{
+  if (!filename)
+    return nullptr;
+  AGXExporter exporter = agxNewExporter();
+  if (!exporter)
+    return nullptr;
+  if (!openFileForAppend(exporter->stream, filename, *exporter)) {
+    delete exporter;
+    return nullptr;
   }
+  exporter->streaming = true;
+  return exporter;
+}
 
-  // Time steps section
-  if (ok) {
-    for (uint32_t i = 0; i < exporter->timeSteps; ++i) {
-      const auto &m = exporter->perTimeStep[i];
-      uint32_t paramCount = static_cast<uint32_t>(m.size());
-      ok = ok && writePOD(f, i);
-      ok = ok && writePOD(f, paramCount);
-      if (!ok)
-        break;
-
-      for (const auto &kv : m) {
-        ok = writeParamRecord(f, kv.first, kv.second);
-        if (!ok)
-          break;
-      }
-      if (!ok)
-        break;
-    }
+int agxWriteSplitManifest(AGXExporter exporter,
+    const char *filename,
+    const AGXSplitPart *parts,
+    uint32_t partCount)
+{
+  if (!exporter || !filename || (partCount > 0 && !parts))
+    return 1;
+  for (uint32_t i = 0; i < partCount; ++i) {
+    const AGXSplitPart &p = parts[i];
+    if (!p.filename || p.timeStepCount > exporter->timeSteps
+        || p.firstTimeStep > exporter->timeSteps - p.timeStepCount)
+      return 1;
   }
 
-  std::fclose(f);
+  AGXOutput f;
+  f.stats = &exporter->stats;
+  f.trace = &exporter->trace;
+  f.f = std::fopen(filename, "wb");
+  if (!f.f)
+    return 2;
+
+  AGXPhaseTimer t(&exporter->trace, "agx.write", &exporter->stats.writeSeconds);
+  const char magic[4] = {'A', 'G', 'X', 'M'};
+  uint32_t version = 1;
+  uint32_t endianMarker = 0x01020304;
+  uint32_t objectType = ANARI_GEOMETRY; // as in writeHeader()
+
+  bool ok = writeBytes(f, magic, sizeof(magic)) && writePOD(f, version)
+      && writePOD(f, endianMarker) && writePOD(f, objectType)
+      && writePOD(f, exporter->timeSteps) && writePOD(f, partCount)
+      && writeString(f, exporter->subtype);
+  for (uint32_t i = 0; ok && i < exporter->timeSteps; ++i)
+    ok = writePOD(f, exporter->stepTimes[i]);
+  for (uint32_t i = 0; ok && i < partCount; ++i) {
+    ok = writePOD(f, parts[i].firstTimeStep)
+        && writePOD(f, parts[i].timeStepCount)
+        && writeString(f, std::string(parts[i].filename));
+  }
+  ok = flushOutput(f) && ok;
+  if (std::fclose(f.f) != 0)
+    ok = false;
   return ok ? 0 : 3;
 }
 